@@ -10,18 +10,30 @@
  */
 
 #include <linux/debugfs.h>
+#include <linux/hrtimer.h>
 #include <linux/module.h>
 #include <linux/of_platform.h>
 #include <video/mipi_display.h>
 
 #include "include/trace/dpu_trace.h"
 #include "panel/panel-samsung-drv.h"
+#include "panel-google-binned-lp.h"
+#include "panel-google-calib.h"
+#include "panel-google-dsc.h"
+#include "panel-google-lhbm-od.h"
+#include "panel-google-residency.h"
+#include "panel-google-timing.h"
 
 #define BIGSURF_DDIC_ID_LEN 8
 #define BIGSURF_DIMMING_FRAME 32
 
+#define BIGSURF_SLEEP_OUT_DELAY_MS 120
+#define BIGSURF_DISPLAY_OFF_DELAY_MS 100
+#define BIGSURF_SLEEP_IN_DELAY_MS 120
+
 #define MIPI_DSI_FREQ_DEFAULT 756
 #define MIPI_DSI_FREQ_ALTERNATIVE 776
+#define BIGSURF_DSI_DATA_LANES 4
 
 #define WIDTH_MM 64
 #define HEIGHT_MM 143
@@ -38,6 +50,11 @@ enum bigsurf_lhbm_brt {
 #define LHBM_BRT_LEN (LHBM_BRT_MAX * 2)
 #define LHBM_BRT_CMD_LEN (LHBM_BRT_LEN + 1)
 #define LHBM_COMPENSATION_THRESHOLD 1380
+#define LHBM_COMPENSATION_HYSTERESIS_DEFAULT 16
+#define LHBM_COMPENSATION_MIN_INTERVAL_MS_DEFAULT 100
+/* AOD DBV of the low (10 nits) and high (50 nits) bins */
+#define BIGSURF_AOD_DBV_LOW 0x333
+#define BIGSURF_AOD_DBV_HIGH 0xFFE
 
 enum bigsurf_lhbm_brt_overdrive_group {
 	LHBM_OVERDRIVE_GRP_0_NIT = 0,
@@ -46,18 +63,75 @@ enum bigsurf_lhbm_brt_overdrive_group {
 	LHBM_OVERDRIVE_GRP_MAX
 };
 
+static const struct lhbm_od_channel bigsurf_lhbm_od_channels[] = {
+	{ .type = LHBM_OD_BE16, .fine = LHBM_R * 2 },
+	{ .type = LHBM_OD_BE16, .fine = LHBM_G * 2 },
+	{ .type = LHBM_OD_BE16, .fine = LHBM_B * 2 },
+};
+
+/* offsets added to the 16-bit R, G and B values */
+static const struct lhbm_od_offset
+bigsurf_lhbm_od_offsets[LHBM_OVERDRIVE_GRP_MAX][LHBM_OD_MAX_CHANNELS] = {
+	/* 0 nit */
+	[LHBM_OVERDRIVE_GRP_0_NIT] = {
+		{ .fine_0 = 0xB5 }, { .fine_0 = 0x85 }, { .fine_0 = 0xBA },
+	},
+	/* 0-15 nit */
+	[LHBM_OVERDRIVE_GRP_15_NIT] = {
+		{ .fine_0 = 0x6E }, { .fine_0 = 0x5A }, { .fine_0 = 0x78 },
+	},
+	/* 15-200 nit */
+	[LHBM_OVERDRIVE_GRP_200_NIT] = {
+		{ .fine_0 = 0x46 }, { .fine_0 = 0x32 }, { .fine_0 = 0x50 },
+	},
+};
+
+static const struct lhbm_od_desc bigsurf_lhbm_od_desc = {
+	.reg = 0xD0, /* bigsurf_lhbm_brightness_reg */
+	.brt_len = LHBM_BRT_LEN,
+	.channels = bigsurf_lhbm_od_channels,
+	.num_channels = ARRAY_SIZE(bigsurf_lhbm_od_channels),
+	.offsets = bigsurf_lhbm_od_offsets,
+	.num_groups = LHBM_OVERDRIVE_GRP_MAX,
+};
+
 struct bigsurf_lhbm_ctl {
 	/** @brt_normal: normal LHBM brightness parameters */
 	u8 brt_normal[LHBM_BRT_LEN];
-	/** @brt_overdrive: overdrive LHBM brightness parameters */
-	u8 brt_overdrive[LHBM_OVERDRIVE_GRP_MAX][LHBM_BRT_LEN];
-	/** @overdrived: whether or not LHBM is overdrived */
-	bool overdrived;
+	/** @od: overdrive state and precomputed brightness commands */
+	struct lhbm_od od;
 	/** @hist_roi_configured: whether LHBM histogram configuration is done */
 	bool hist_roi_configured;
 };
 
-static const u8 bigsurf_cmd2_page2[] = {0xF0, 0x55, 0xAA, 0x52, 0x08, 0x02};
+/* CMD2 page is not known, e.g. after reset or a command set selecting pages on its own */
+#define BIGSURF_CMD2_PAGE_UNKNOWN 0xFF
+/**
+ * struct bigsurf_lhbm_comp - LHBM compensation state for panels before MP
+ *
+ * The compensation table on CMD2 page 8 depends on whether brightness is above
+ * LHBM_COMPENSATION_THRESHOLD. To avoid rewriting it while brightness drifts around
+ * the threshold, the table is only switched once brightness leaves a band of
+ * @hysteresis levels around it, and no more often than every @min_interval_ms. A
+ * switch held back by the interval is applied by @work.
+ */
+struct bigsurf_lhbm_comp {
+	/** @high: whether the table for brightness above the threshold is applied */
+	bool high;
+	/** @hysteresis: half width of the band around the threshold, in DBV levels */
+	u16 hysteresis;
+	/** @min_interval_ms: minimum time between two table updates */
+	u32 min_interval_ms;
+	/** @last_update_ts: time of the last table update */
+	ktime_t last_update_ts;
+	/** @crossings: number of times brightness crossed the threshold */
+	u32 crossings;
+	/** @updates: number of table updates sent to the panel */
+	u32 updates;
+	/** @work: delayed table update held back by @min_interval_ms */
+	struct delayed_work work;
+};
+
 static const u8 bigsurf_lhbm_brightness_reg = 0xD0;
 
 /**
@@ -71,14 +145,76 @@ struct bigsurf_panel {
 	struct exynos_panel base;
 	/** @lhbm_ctl: LHBM control parameters */
 	struct bigsurf_lhbm_ctl lhbm_ctl;
-	/** @idle_exit_dimming_delay_ts: the delay time to exit dimming */
-	ktime_t idle_exit_dimming_delay_ts;
+	/** @idle_exit_dimming_timer: fires when dimming can be restored after idle exit */
+	struct hrtimer idle_exit_dimming_timer;
+	/** @idle_exit_dimming_work: restores dimming, queued by @idle_exit_dimming_timer */
+	struct work_struct idle_exit_dimming_work;
+	/** @idle_exit_dimming_pending: dimming restore is due, protected by mode_lock */
+	bool idle_exit_dimming_pending;
 	/** @panel_brightness: the brightness of the panel */
 	u16 panel_brightness;
+	/** @lhbm_comp: LHBM compensation state */
+	struct bigsurf_lhbm_comp lhbm_comp;
+	/** @power_off_ts: earliest time the panel power may be cut after sleep in */
+	ktime_t power_off_ts;
+	/**
+	 * @cmd2_page: CMD2 page selected in the panel, or BIGSURF_CMD2_PAGE_UNKNOWN. It's
+	 *             updated as page selects are queued and remains valid across flushes
+	 *             until something else touches the page selection.
+	 */
+	u8 cmd2_page;
+	/** @residency: time spent in each power state */
+	struct panel_residency residency;
+	/** @binned_lp_hysteresis: brightness levels to move past a bin threshold in AOD */
+	u16 binned_lp_hysteresis;
+	/**
+	 * @aod_continuous: on an AOD bin switch, scale the DBV with brightness between the
+	 *		    low and high bins instead of using the fixed DBV of the bin
+	 */
+	bool aod_continuous;
+	/** @aod_dbv_bin: bin the scaled AOD DBV was last written for, cleared on LP entry */
+	const struct exynos_binned_lp *aod_dbv_bin;
 };
 
 #define to_spanel(ctx) container_of(ctx, struct bigsurf_panel, base)
 
+/**
+ * bigsurf_cmd2_page_buf_add - queue a CMD2 page select unless it's already selected
+ * @ctx: panel struct
+ * @page: CMD2 page number
+ */
+static void bigsurf_cmd2_page_buf_add(struct exynos_panel *ctx, u8 page)
+{
+	struct bigsurf_panel *spanel = to_spanel(ctx);
+
+	if (spanel->cmd2_page == page)
+		return;
+
+	EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, page);
+	spanel->cmd2_page = page;
+}
+
+/**
+ * bigsurf_cmd2_page_select - select a CMD2 page right away, e.g. ahead of a read
+ * @ctx: panel struct
+ * @page: CMD2 page number
+ */
+static void bigsurf_cmd2_page_select(struct exynos_panel *ctx, u8 page)
+{
+	struct bigsurf_panel *spanel = to_spanel(ctx);
+
+	if (spanel->cmd2_page == page)
+		return;
+
+	EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, page);
+	spanel->cmd2_page = page;
+}
+
+static inline void bigsurf_cmd2_page_invalidate(struct exynos_panel *ctx)
+{
+	to_spanel(ctx)->cmd2_page = BIGSURF_CMD2_PAGE_UNKNOWN;
+}
+
 static const struct exynos_dsi_cmd bigsurf_lp_cmds[] = {
 	/* Disable the Black insertion in AoD */
 	EXYNOS_DSI_CMD_SEQ(0xF0, 0x55, 0xAA, 0x52, 0x08, 0x00),
@@ -100,13 +236,15 @@ static const struct exynos_dsi_cmd bigsurf_lp_off_cmds[] = {
 static const struct exynos_dsi_cmd bigsurf_lp_low_cmds[] = {
 	/* 10 nit */
 	EXYNOS_DSI_CMD_SEQ(0x6F, 0x04),
-	EXYNOS_DSI_CMD_SEQ(MIPI_DCS_SET_DISPLAY_BRIGHTNESS, 0x03, 0x33),
+	EXYNOS_DSI_CMD_SEQ(MIPI_DCS_SET_DISPLAY_BRIGHTNESS, BIGSURF_AOD_DBV_LOW >> 8,
+			   BIGSURF_AOD_DBV_LOW & 0xFF),
 };
 
 static const struct exynos_dsi_cmd bigsurf_lp_high_cmds[] = {
 	/* 50 nit */
 	EXYNOS_DSI_CMD_SEQ(0x6F, 0x04),
-	EXYNOS_DSI_CMD_SEQ(MIPI_DCS_SET_DISPLAY_BRIGHTNESS, 0x0F, 0xFE),
+	EXYNOS_DSI_CMD_SEQ(MIPI_DCS_SET_DISPLAY_BRIGHTNESS, BIGSURF_AOD_DBV_HIGH >> 8,
+			   BIGSURF_AOD_DBV_HIGH & 0xFF),
 };
 
 static const struct exynos_binned_lp bigsurf_binned_lp[] = {
@@ -118,8 +256,9 @@ static const struct exynos_binned_lp bigsurf_binned_lp[] = {
 };
 
 static const struct exynos_dsi_cmd bigsurf_off_cmds[] = {
-	EXYNOS_DSI_CMD_SEQ_DELAY(100, MIPI_DCS_SET_DISPLAY_OFF),
-	EXYNOS_DSI_CMD_SEQ_DELAY(120, MIPI_DCS_ENTER_SLEEP_MODE),
+	EXYNOS_DSI_CMD_SEQ_DELAY(BIGSURF_DISPLAY_OFF_DELAY_MS, MIPI_DCS_SET_DISPLAY_OFF),
+	/* the sleep in settle time is a deadline checked before power off */
+	EXYNOS_DSI_CMD_SEQ(MIPI_DCS_ENTER_SLEEP_MODE),
 };
 static DEFINE_EXYNOS_CMD_SET(bigsurf_off);
 
@@ -319,7 +458,7 @@ static const struct exynos_dsi_cmd bigsurf_init_cmds[] = {
 				0x46, 0x00, 0x00, 0x44, 0x00, 0x00, 0x41, 0x00,
 				0x00),
 
-	EXYNOS_DSI_CMD_SEQ_DELAY(120, MIPI_DCS_EXIT_SLEEP_MODE)
+	EXYNOS_DSI_CMD_SEQ_DELAY(BIGSURF_SLEEP_OUT_DELAY_MS, MIPI_DCS_EXIT_SLEEP_MODE)
 };
 static DEFINE_EXYNOS_CMD_SET(bigsurf_init);
 
@@ -375,7 +514,7 @@ static void bigsurf_update_irc(struct exynos_panel *ctx,
 		EXYNOS_DCS_BUF_ADD(ctx, 0x5F, 0x01);
 		if (vrefresh == 120) {
 			if (ctx->hbm.local_hbm.enabled) {
-				EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x00);
+				bigsurf_cmd2_page_buf_add(ctx, 0);
 				EXYNOS_DCS_BUF_ADD(ctx, 0x6F, 0x04);
 				EXYNOS_DCS_BUF_ADD(ctx, 0xC0, 0x76);
 			}
@@ -383,18 +522,18 @@ static void bigsurf_update_irc(struct exynos_panel *ctx,
 			EXYNOS_DCS_BUF_ADD(ctx, MIPI_DCS_SET_GAMMA_CURVE, 0x02);
 		} else {
 			EXYNOS_DCS_BUF_ADD(ctx, 0x2F, 0x30);
-			EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x00);
+			bigsurf_cmd2_page_buf_add(ctx, 0);
 			EXYNOS_DCS_BUF_ADD(ctx, 0x6F, 0xB0);
 			EXYNOS_DCS_BUF_ADD(ctx, 0xBA, 0x44);
 		}
-		EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x00);
+		bigsurf_cmd2_page_buf_add(ctx, 0);
 		EXYNOS_DCS_BUF_ADD(ctx, 0x6F, 0x03);
 		EXYNOS_DCS_BUF_ADD(ctx, 0xC0, 0x32);
 	} else {
 		EXYNOS_DCS_BUF_ADD(ctx, 0x5F, 0x00);
 		if (vrefresh == 120) {
 			if (ctx->hbm.local_hbm.enabled) {
-				EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x00);
+				bigsurf_cmd2_page_buf_add(ctx, 0);
 				EXYNOS_DCS_BUF_ADD(ctx, 0x6F, 0x04);
 				EXYNOS_DCS_BUF_ADD(ctx, 0xC0, 0x75);
 			}
@@ -402,11 +541,11 @@ static void bigsurf_update_irc(struct exynos_panel *ctx,
 			EXYNOS_DCS_BUF_ADD(ctx, MIPI_DCS_SET_GAMMA_CURVE, 0x00);
 		} else {
 			EXYNOS_DCS_BUF_ADD(ctx, 0x2F, 0x30);
-			EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x00);
+			bigsurf_cmd2_page_buf_add(ctx, 0);
 			EXYNOS_DCS_BUF_ADD(ctx, 0x6F, 0xB0);
 			EXYNOS_DCS_BUF_ADD(ctx, 0xBA, 0x41);
 		}
-		EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x00);
+		bigsurf_cmd2_page_buf_add(ctx, 0);
 		EXYNOS_DCS_BUF_ADD(ctx, 0x6F, 0x03);
 		EXYNOS_DCS_BUF_ADD(ctx, 0xC0, 0x30);
 		if (ctx->panel_rev >= PANEL_REV_EVT1) {
@@ -433,6 +572,16 @@ static bool bigsurf_rr_need_te_high(struct exynos_panel *ctx,
 	return false;
 }
 
+/* @pmode is the mode the panel runs at, it may not be current_mode yet */
+static void bigsurf_update_residency(struct exynos_panel *ctx,
+				     const struct exynos_panel_mode *pmode)
+{
+	struct bigsurf_panel *spanel = to_spanel(ctx);
+
+	panel_residency_sample(ctx, &spanel->residency,
+			       pmode && is_panel_active(ctx) ? drm_mode_vrefresh(&pmode->mode) : 0);
+}
+
 static void bigsurf_change_frequency(struct exynos_panel *ctx,
 				    const struct exynos_panel_mode *pmode)
 {
@@ -456,13 +605,14 @@ static void bigsurf_change_frequency(struct exynos_panel *ctx,
 			EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, MIPI_DCS_SET_GAMMA_CURVE, 0x00);
 		} else {
 			EXYNOS_DCS_BUF_ADD(ctx, 0x2F, 0x30);
-			EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x00);
+			bigsurf_cmd2_page_buf_add(ctx, 0);
 			EXYNOS_DCS_BUF_ADD(ctx, 0x6F, 0xB0);
 			EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, 0xBA, 0x41);
 		}
 	} else {
 		bigsurf_update_irc(ctx, ctx->hbm_mode, vrefresh);
 	}
+	bigsurf_update_residency(ctx, pmode);
 
 	dev_dbg(ctx->dev, "%s: change to %uhz\n", __func__, vrefresh);
 }
@@ -483,6 +633,125 @@ static void bigsurf_set_dimming_on(struct exynos_panel *ctx,
 	dev_dbg(ctx->dev, "%s dimming_on=%d\n", __func__, dimming_on);
 }
 
+/**
+ * bigsurf_wait_for_deadline - sleep until a deadline set by an earlier command
+ * @ctx: panel struct
+ * @deadline: time to wait for, nothing to wait if 0 or in the past
+ *
+ * The settle time after sleep in is tracked as a deadline rather than slept right
+ * away, so that DPU and DSIM teardown can go on in the meantime.
+ */
+static void bigsurf_wait_for_deadline(struct exynos_panel *ctx, ktime_t deadline)
+{
+	s64 remaining_us;
+
+	if (!deadline)
+		return;
+
+	remaining_us = ktime_us_delta(deadline, ktime_get());
+	if (remaining_us <= 0)
+		return;
+
+	DPU_ATRACE_BEGIN(__func__);
+	dev_dbg(ctx->dev, "%s: %lldus\n", __func__, remaining_us);
+	usleep_range(remaining_us, remaining_us + 100);
+	DPU_ATRACE_END(__func__);
+}
+
+static void bigsurf_cancel_idle_exit_dimming(struct exynos_panel *ctx)
+{
+	struct bigsurf_panel *spanel = to_spanel(ctx);
+
+	spanel->idle_exit_dimming_pending = false;
+	/* waits for a running callback, which only queues the work */
+	hrtimer_cancel(&spanel->idle_exit_dimming_timer);
+}
+
+static enum hrtimer_restart bigsurf_idle_exit_dimming_timer(struct hrtimer *timer)
+{
+	struct bigsurf_panel *spanel = container_of(timer, struct bigsurf_panel,
+						    idle_exit_dimming_timer);
+
+	schedule_work(&spanel->idle_exit_dimming_work);
+
+	return HRTIMER_NORESTART;
+}
+
+static void bigsurf_idle_exit_dimming_work(struct work_struct *work)
+{
+	struct bigsurf_panel *spanel = container_of(work, struct bigsurf_panel,
+						    idle_exit_dimming_work);
+	struct exynos_panel *ctx = &spanel->base;
+
+	mutex_lock(&ctx->mode_lock);
+	if (spanel->idle_exit_dimming_pending && is_panel_active(ctx) &&
+	    ctx->current_mode && !ctx->current_mode->exynos_mode.is_lp_mode) {
+		DPU_ATRACE_BEGIN(__func__);
+		EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, MIPI_DCS_WRITE_CONTROL_DISPLAY,
+					     ctx->dimming_on ? 0x28 : 0x20);
+		DPU_ATRACE_END(__func__);
+		dev_dbg(ctx->dev, "%s: dimming_on=%d\n", __func__, ctx->dimming_on);
+	}
+	spanel->idle_exit_dimming_pending = false;
+	mutex_unlock(&ctx->mode_lock);
+}
+
+/*
+ * Follow the command set of a new AOD bin with a DBV interpolated between the
+ * thresholds of the first and last bins with a brightness range. Brightness
+ * updates within a bin keep the DBV.
+ */
+static void bigsurf_aod_dbv_update(struct exynos_panel *ctx, u16 br)
+{
+	struct bigsurf_panel *spanel = to_spanel(ctx);
+	const struct exynos_binned_lp *bin = ctx->current_binned_lp;
+	const struct exynos_binned_lp *bins = ctx->desc->binned_lp;
+	u32 lo = 0, hi = 0, dbv;
+	int i;
+
+	if (!spanel->aod_continuous || !bin || !bin->bl_threshold || bin == spanel->aod_dbv_bin)
+		return;
+
+	for (i = 0; i < ctx->desc->num_binned_lp; i++) {
+		if (!bins[i].bl_threshold)
+			continue;
+		if (!lo)
+			lo = bins[i].bl_threshold;
+		hi = bins[i].bl_threshold;
+	}
+	if (hi <= lo)
+		return;
+
+	dbv = BIGSURF_AOD_DBV_LOW + (clamp_t(u32, br, lo, hi) - lo) *
+	      (BIGSURF_AOD_DBV_HIGH - BIGSURF_AOD_DBV_LOW) / (hi - lo);
+
+	EXYNOS_DCS_BUF_ADD(ctx, 0x6F, 0x04);
+	EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, MIPI_DCS_SET_DISPLAY_BRIGHTNESS, dbv >> 8, dbv & 0xFF);
+	spanel->aod_dbv_bin = bin;
+	dev_dbg(ctx->dev, "%s: br=%u dbv=%#x\n", __func__, br, dbv);
+}
+
+static void bigsurf_set_binned_lp(struct exynos_panel *ctx, const u16 brightness)
+{
+	struct bigsurf_panel *spanel = to_spanel(ctx);
+
+	exynos_panel_set_binned_lp(ctx, binned_lp_hysteresis(ctx, brightness,
+							     spanel->binned_lp_hysteresis));
+	bigsurf_aod_dbv_update(ctx, brightness);
+}
+
+static void bigsurf_set_lp_mode(struct exynos_panel *ctx,
+				const struct exynos_panel_mode *pmode)
+{
+	/* lp_cmd_set turns dimming off, a pending restore must not undo that */
+	bigsurf_cancel_idle_exit_dimming(ctx);
+	to_spanel(ctx)->aod_dbv_bin = NULL;
+	exynos_panel_set_lp_mode(ctx, pmode);
+	/* lp_cmd_set selects the CMD2 page without going through the cache */
+	bigsurf_cmd2_page_invalidate(ctx);
+	bigsurf_update_residency(ctx, pmode);
+}
+
 static void bigsurf_set_nolp_mode(struct exynos_panel *ctx,
 				  const struct exynos_panel_mode *pmode)
 {
@@ -492,24 +761,116 @@ static void bigsurf_set_nolp_mode(struct exynos_panel *ctx,
 		return;
 
 	/* exit AOD */
-	EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x00);
+	bigsurf_cmd2_page_buf_add(ctx, 0);
 	EXYNOS_DCS_BUF_ADD(ctx, 0xC0, 0x54);
 	EXYNOS_DCS_BUF_ADD(ctx, MIPI_DCS_EXIT_IDLE_MODE);
 	EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, 0x5A, 0x04);
 
 	bigsurf_change_frequency(ctx, pmode);
-	spanel->idle_exit_dimming_delay_ts = ktime_add_us(
-		ktime_get(), 100 + EXYNOS_VREFRESH_TO_PERIOD_USEC(vrefresh) * 2);
+	/* restore dimming once the panel is out of AOD, two frames from now */
+	spanel->idle_exit_dimming_pending = true;
+	hrtimer_start(&spanel->idle_exit_dimming_timer,
+		      us_to_ktime(100 + EXYNOS_VREFRESH_TO_PERIOD_USEC(vrefresh) * 2),
+		      HRTIMER_MODE_REL);
 
 	dev_info(ctx->dev, "exit LP mode\n");
 }
 
+static bool bigsurf_lhbm_comp_want_high(const struct bigsurf_lhbm_comp *comp, u16 br)
+{
+	if (comp->high)
+		return br + comp->hysteresis >= LHBM_COMPENSATION_THRESHOLD;
+
+	return br >= LHBM_COMPENSATION_THRESHOLD + comp->hysteresis;
+}
+
+/**
+ * bigsurf_lhbm_comp_buf_add - queue the compensation table for one side of the threshold
+ * @ctx: panel struct
+ * @high: whether brightness is above the threshold
+ * @flush: whether to flush along with the table
+ */
+static void bigsurf_lhbm_comp_buf_add(struct exynos_panel *ctx, bool high, bool flush)
+{
+	struct bigsurf_lhbm_comp *comp = &to_spanel(ctx)->lhbm_comp;
+	static const u8 comp_table[2][21] = {
+		{0xD0, 0x44, 0x00, 0x00, 0x44, 0x00, 0x00, 0x44, 0x00, 0x00, 0x04,
+		 0x00, 0x4A, 0x00, 0x00, 0x44, 0x00, 0x00, 0x40, 0xAA, 0x00}, /* low */
+		{0xD0, 0x44, 0x00, 0x00, 0x44, 0x00, 0x00, 0x44, 0x00, 0x00, 0x04,
+		 0x00, 0x46, 0x00, 0x00, 0x44, 0x00, 0x00, 0x41, 0x00, 0x00}, /* high */
+	};
+
+	bigsurf_cmd2_page_buf_add(ctx, 8);
+	if (flush)
+		EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, comp_table[high]);
+	else
+		EXYNOS_DCS_BUF_ADD_SET(ctx, comp_table[high]);
+	comp->high = high;
+	comp->last_update_ts = ktime_get();
+	comp->updates++;
+	dev_dbg(ctx->dev, "%s: %s threshold\n", __func__, high ? "above" : "below");
+}
+
+/**
+ * bigsurf_lhbm_comp_update - queue a compensation table switch if brightness needs one
+ * @ctx: panel struct
+ * @br: new brightness
+ *
+ * Return: true if a table update was queued, the caller is responsible for flushing.
+ */
+static bool bigsurf_lhbm_comp_update(struct exynos_panel *ctx, u16 br)
+{
+	struct bigsurf_panel *spanel = to_spanel(ctx);
+	struct bigsurf_lhbm_comp *comp = &spanel->lhbm_comp;
+	const bool high = bigsurf_lhbm_comp_want_high(comp, br);
+	s64 wait_ms;
+
+	if ((spanel->panel_brightness < LHBM_COMPENSATION_THRESHOLD) ^
+	    (br < LHBM_COMPENSATION_THRESHOLD))
+		comp->crossings++;
+
+	if (high == comp->high) {
+		cancel_delayed_work(&comp->work);
+		return false;
+	}
+
+	wait_ms = comp->min_interval_ms -
+		  ktime_ms_delta(ktime_get(), comp->last_update_ts);
+	if (wait_ms > 0) {
+		mod_delayed_work(system_wq, &comp->work, msecs_to_jiffies(wait_ms));
+		return false;
+	}
+
+	bigsurf_lhbm_comp_buf_add(ctx, high, false);
+	return true;
+}
+
+static void bigsurf_lhbm_comp_work(struct work_struct *work)
+{
+	struct bigsurf_panel *spanel = container_of(work, struct bigsurf_panel,
+						    lhbm_comp.work.work);
+	struct exynos_panel *ctx = &spanel->base;
+	struct bigsurf_lhbm_comp *comp = &spanel->lhbm_comp;
+	bool high;
+
+	mutex_lock(&ctx->mode_lock);
+	if (!is_panel_active(ctx) || !ctx->current_mode ||
+	    ctx->current_mode->exynos_mode.is_lp_mode)
+		goto done;
+
+	high = bigsurf_lhbm_comp_want_high(comp, spanel->panel_brightness);
+	if (high != comp->high)
+		bigsurf_lhbm_comp_buf_add(ctx, high, true);
+done:
+	mutex_unlock(&ctx->mode_lock);
+}
+
 static void bigsurf_dimming_frame_setting(struct exynos_panel *ctx, u8 dimming_frame)
 {
 	if (!dimming_frame)
 		dimming_frame = 0x01;
 
-	EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x00);
+	bigsurf_cmd2_page_buf_add(ctx, 0);
 	EXYNOS_DCS_BUF_ADD(ctx, 0xB2, 0x19);
 	EXYNOS_DCS_BUF_ADD(ctx, 0x6F, 0x05);
 	EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, 0xB2, dimming_frame, dimming_frame);
@@ -528,21 +889,34 @@ static int bigsurf_enable(struct drm_panel *panel)
 
 	dev_dbg(ctx->dev, "%s\n", __func__);
 
+	/* the panel may still be settling from a sleep in without a power cycle */
+	bigsurf_wait_for_deadline(ctx, spanel->power_off_ts);
+	spanel->power_off_ts = 0;
+
 	exynos_panel_reset(ctx);
 	exynos_panel_send_cmd_set(ctx, &bigsurf_init_cmd_set);
+	/* the init sequence walks through several pages, don't rely on where it ends */
+	bigsurf_cmd2_page_invalidate(ctx);
+	/* init_cmd_set applies the compensation table for brightness above the threshold */
+	spanel->lhbm_comp.high = true;
+	spanel->lhbm_comp.last_update_ts = 0;
 	bigsurf_change_frequency(ctx, pmode);
+	if (ctx->panel_rev < PANEL_REV_MP &&
+	    !bigsurf_lhbm_comp_want_high(&spanel->lhbm_comp, spanel->panel_brightness))
+		bigsurf_lhbm_comp_buf_add(ctx, false, false);
+	/* flushes the compensation table along with the dimming setting */
 	bigsurf_dimming_frame_setting(ctx, BIGSURF_DIMMING_FRAME);
-	spanel->idle_exit_dimming_delay_ts = 0;
+	bigsurf_cancel_idle_exit_dimming(ctx);
 
 	if (!pmode->exynos_mode.is_lp_mode) {
 		if (ctx->panel_rev < PANEL_REV_EVT1) {
 			/* Gamma update setting */
-			EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x02);
+			bigsurf_cmd2_page_buf_add(ctx, 2);
 			EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, 0xCC, 0x10);
 			exynos_panel_msleep(9);
 		}
 	} else {
-		exynos_panel_set_lp_mode(ctx, pmode);
+		bigsurf_set_lp_mode(ctx, pmode);
 	}
 
 	EXYNOS_DCS_WRITE_SEQ(ctx, MIPI_DCS_SET_DISPLAY_ON);
@@ -578,6 +952,11 @@ static void bigsurf_update_lhbm_hist_config(struct exynos_panel *ctx)
 	}
 }
 
+static void bigsurf_commit_done(struct exynos_panel *ctx)
+{
+	bigsurf_update_residency(ctx, ctx->current_mode);
+}
+
 static int bigsurf_atomic_check(struct exynos_panel *ctx, struct drm_atomic_state *state)
 {
 	struct drm_connector *conn = &ctx->exynos_connector.base;
@@ -641,7 +1020,7 @@ static void bigsurf_pre_update_ffc(struct exynos_panel *ctx)
 	DPU_ATRACE_BEGIN(__func__);
 
 	/* FFC off */
-	EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x01);
+	bigsurf_cmd2_page_buf_add(ctx, 1);
 	EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, 0xC3, 0x00);
 
 	DPU_ATRACE_END(__func__);
@@ -661,7 +1040,7 @@ static void bigsurf_update_ffc(struct exynos_panel *ctx, unsigned int hs_clk)
 		ctx->dsi_hs_clk = hs_clk;
 
 		/* Update FFC */
-		EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x01);
+		bigsurf_cmd2_page_buf_add(ctx, 1);
 		if (hs_clk == MIPI_DSI_FREQ_DEFAULT)
 			EXYNOS_DCS_BUF_ADD(ctx, 0xC3, 0x00, 0x06, 0x20, 0x0C, 0xFF,
 						0x00, 0x06, 0x20, 0x0C, 0xFF, 0x00,
@@ -681,7 +1060,7 @@ static void bigsurf_update_ffc(struct exynos_panel *ctx, unsigned int hs_clk)
 	}
 
 	/* FFC on */
-	EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x01);
+	bigsurf_cmd2_page_buf_add(ctx, 1);
 	EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, 0xC3, 0xDD);
 
 	DPU_ATRACE_END(__func__);
@@ -701,7 +1080,7 @@ static void bigsurf_set_local_hbm_background_brightness(struct exynos_panel *ctx
 	val2 = level & 0xff;
 
 	/* set LHBM background brightness */
-	EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x00);
+	bigsurf_cmd2_page_buf_add(ctx, 0);
 	EXYNOS_DCS_BUF_ADD(ctx, 0x6F, 0x4C);
 	EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, 0xDF, val1, val2, val1, val2, val1, val2);
 }
@@ -709,8 +1088,6 @@ static void bigsurf_set_local_hbm_background_brightness(struct exynos_panel *ctx
 static int bigsurf_set_brightness(struct exynos_panel *ctx, u16 br)
 {
 	struct bigsurf_panel *spanel = to_spanel(ctx);
-	u16 old_brightness = spanel->panel_brightness;
-	bool low_to_high;
 
 	if (ctx->current_mode->exynos_mode.is_lp_mode) {
 		const struct exynos_panel_funcs *funcs;
@@ -718,34 +1095,16 @@ static int bigsurf_set_brightness(struct exynos_panel *ctx, u16 br)
 		funcs = ctx->desc->exynos_panel_func;
 		if (funcs && funcs->set_binned_lp)
 			funcs->set_binned_lp(ctx, br);
+		bigsurf_update_residency(ctx, ctx->current_mode);
 		return 0;
 	}
 
-	if (br) {
-		if (ctx->hbm.local_hbm.enabled)
-			bigsurf_set_local_hbm_background_brightness(ctx, br);
-
-		if (spanel->idle_exit_dimming_delay_ts &&
-			(ktime_sub(spanel->idle_exit_dimming_delay_ts, ktime_get()) <= 0)) {
-			EXYNOS_DCS_BUF_ADD(ctx, MIPI_DCS_WRITE_CONTROL_DISPLAY,
-						ctx->dimming_on ? 0x28 : 0x20);
-			spanel->idle_exit_dimming_delay_ts = 0;
-		}
-	}
+	if (br && ctx->hbm.local_hbm.enabled)
+		bigsurf_set_local_hbm_background_brightness(ctx, br);
 
 	/* Check for passing brightness threshold */
-	if ((ctx->panel_rev < PANEL_REV_MP) &&
-	    ((old_brightness < LHBM_COMPENSATION_THRESHOLD) ^ (br < LHBM_COMPENSATION_THRESHOLD))) {
-		low_to_high = old_brightness < LHBM_COMPENSATION_THRESHOLD;
-		EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x08);
-		EXYNOS_DCS_BUF_ADD(ctx, 0xD0, 0x44, 0x00, 0x00, 0x44, 0x00,
-					0x00, 0x44, 0x00, 0x00, 0x04,
-					0x00, low_to_high ? 0x46: 0x4A,
-					0x00, 0x00, 0x44, 0x00, 0x00,
-					low_to_high ? 0x41 : 0x40,
-					low_to_high ? 0x00 : 0xAA,
-					0x00);
-	}
+	if (ctx->panel_rev < PANEL_REV_MP)
+		bigsurf_lhbm_comp_update(ctx, br);
 	if (IS_HBM_ON_IRC_OFF(ctx->hbm_mode) && ctx->panel_rev >= PANEL_REV_EVT1 &&
 	    br == ctx->desc->brt_capability->hbm.level.max) {
 		EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, MIPI_DCS_SET_DISPLAY_BRIGHTNESS, 0x0F, 0xFF);
@@ -755,6 +1114,7 @@ static int bigsurf_set_brightness(struct exynos_panel *ctx, u16 br)
 						br & 0xff);
 	}
 	spanel->panel_brightness = br;
+	bigsurf_update_residency(ctx, ctx->current_mode);
 	return 0;
 }
 
@@ -770,6 +1130,7 @@ static void bigsurf_set_hbm_mode(struct exynos_panel *ctx,
 	bigsurf_update_irc(ctx, hbm_mode, vrefresh);
 
 	ctx->hbm_mode = hbm_mode;
+	bigsurf_update_residency(ctx, pmode);
 	dev_info(ctx->dev, "hbm_on=%d hbm_ircoff=%d\n", IS_HBM_ON(ctx->hbm_mode),
 		 IS_HBM_ON_IRC_OFF(ctx->hbm_mode));
 }
@@ -778,10 +1139,9 @@ static void bigsurf_set_local_hbm_brightness(struct exynos_panel *ctx, bool is_f
 {
 	struct bigsurf_panel *spanel = to_spanel(ctx);
 	struct bigsurf_lhbm_ctl *ctl = &spanel->lhbm_ctl;
-	const u8 *brt;
 	enum bigsurf_lhbm_brt_overdrive_group group = LHBM_OVERDRIVE_GRP_MAX;
-	static u8 cmd[LHBM_BRT_CMD_LEN];
-	int i;
+	u8 cmd[LHBM_BRT_CMD_LEN];
+	const u8 *od_cmd;
 
 	dev_info(ctx->dev, "set LHBM brightness at %s stage\n", is_first_stage ? "1st" : "2nd");
 	if (is_first_stage) {
@@ -798,24 +1158,18 @@ static void bigsurf_set_local_hbm_brightness(struct exynos_panel *ctx, bool is_f
 			group = LHBM_OVERDRIVE_GRP_200_NIT;
 		else
 			group = LHBM_OVERDRIVE_GRP_MAX;
-		brt = group < LHBM_OVERDRIVE_GRP_MAX ?
-			ctl->brt_overdrive[group] : ctl->brt_normal;
 	}
 
-	if (group < LHBM_OVERDRIVE_GRP_MAX) {
-		brt = ctl->brt_overdrive[group];
-		ctl->overdrived = true;
-	} else {
-		brt = ctl->brt_normal;
-		ctl->overdrived = false;
+	od_cmd = lhbm_od_select(&ctl->od, group);
+	if (!od_cmd) {
+		dev_err(ctx->dev, "%s: no lhbm brightness\n", __func__);
+		return;
 	}
-	cmd[0] = bigsurf_lhbm_brightness_reg;
-	for (i = 0; i < LHBM_BRT_LEN; i++)
-		cmd[i+1] = brt[i];
+	memcpy(cmd, od_cmd, sizeof(cmd));
 	dev_dbg(ctx->dev, "set %s brightness: [%d] %*ph\n",
-		ctl->overdrived ? "overdrive" : "normal",
-		ctl->overdrived ? group : -1, LHBM_BRT_LEN, brt);
-	EXYNOS_DCS_BUF_ADD_SET(ctx, bigsurf_cmd2_page2);
+		lhbm_od_is_overdrived(&ctl->od) ? "overdrive" : "normal",
+		lhbm_od_is_overdrived(&ctl->od) ? group : -1, LHBM_BRT_LEN, cmd + 1);
+	bigsurf_cmd2_page_buf_add(ctx, 2);
 	EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, cmd);
 }
 
@@ -831,7 +1185,7 @@ static void bigsurf_set_local_hbm_mode(struct exynos_panel *ctx,
 		if (IS_HBM_ON(ctx->hbm_mode)) {
 			bigsurf_update_irc(ctx, ctx->hbm_mode, vrefresh);
 		} else if (vrefresh == 120) {
-			EXYNOS_DCS_BUF_ADD(ctx, 0xF0, 0x55, 0xAA, 0x52, 0x08, 0x00);
+			bigsurf_cmd2_page_buf_add(ctx, 0);
 			EXYNOS_DCS_BUF_ADD(ctx, 0x6F, 0x04);
 			EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, 0xC0, 0x75);
 		} else {
@@ -851,7 +1205,7 @@ static void bigsurf_set_local_hbm_mode_post(struct exynos_panel *ctx)
 {
 	const struct bigsurf_panel *spanel = to_spanel(ctx);
 
-	if (spanel->lhbm_ctl.overdrived)
+	if (lhbm_od_is_overdrived(&spanel->lhbm_ctl.od))
 		bigsurf_set_local_hbm_brightness(ctx, false);
 }
 
@@ -888,6 +1242,12 @@ static int bigsurf_read_id(struct exynos_panel *ctx)
 	char buf[BIGSURF_DDIC_ID_LEN] = {0};
 	int ret;
 
+	if (!panel_calib_get(ctx->dev, "google,ddic-id", (u8 *)buf, BIGSURF_DDIC_ID_LEN)) {
+		exynos_bin2hex(buf, BIGSURF_DDIC_ID_LEN,
+			ctx->panel_id, sizeof(ctx->panel_id));
+		return 0;
+	}
+
 	EXYNOS_DCS_WRITE_SEQ(ctx, 0xFF, 0xAA, 0x55, 0xA5, 0x81);
 	ret = mipi_dsi_dcs_read(dsi, 0xF2, buf, BIGSURF_DDIC_ID_LEN);
 	if (ret != BIGSURF_DDIC_ID_LEN) {
@@ -901,6 +1261,7 @@ static int bigsurf_read_id(struct exynos_panel *ctx)
 		ctx->panel_id, sizeof(ctx->panel_id));
 done:
 	EXYNOS_DCS_WRITE_SEQ(ctx, 0xFF, 0xAA, 0x55, 0xA5, 0x00);
+	bigsurf_cmd2_page_invalidate(ctx);
 	return ret;
 }
 
@@ -1030,84 +1391,149 @@ static const struct exynos_panel_mode bigsurf_lp_mode = {
 	}
 };
 
-static void _update_lhbm_overdrive_brightness(struct exynos_panel *ctx,
-	enum bigsurf_lhbm_brt_overdrive_group grp,
-	enum bigsurf_lhbm_brt ch, u8 offset)
-{
-	struct bigsurf_panel *spanel = to_spanel(ctx);
-	u8 *p_norm = spanel->lhbm_ctl.brt_normal;
-	u8 *p_over = spanel->lhbm_ctl.brt_overdrive[grp];
-	u16 val;
-	int p = ch * 2;
-
-	val = (p_norm[p] << 8) | p_norm[p + 1];
-	val += offset;
-	p_over[p] = (val & 0xFF00) >> 8;
-	p_over[p + 1] = val & 0x00FF;
-}
-
 static void bigsurf_lhbm_brightness_init(struct exynos_panel *ctx)
 {
 	struct mipi_dsi_device *dsi = to_mipi_dsi_device(ctx->dev);
 	struct bigsurf_panel *spanel = to_spanel(ctx);
+	struct bigsurf_lhbm_ctl *ctl = &spanel->lhbm_ctl;
 	int ret;
 	enum bigsurf_lhbm_brt_overdrive_group grp;
-	u8 *p_norm = spanel->lhbm_ctl.brt_normal;
-
-	EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, bigsurf_cmd2_page2);
-	ret = mipi_dsi_dcs_read(dsi, bigsurf_lhbm_brightness_reg, p_norm, LHBM_BRT_LEN);
-	if (ret != LHBM_BRT_LEN) {
-		dev_err(ctx->dev, "failed to read lhbm brightness ret=%d\n", ret);
-		return;
+	u8 *p_norm = ctl->brt_normal;
+
+	if (panel_calib_get(ctx->dev, "google,lhbm-brightness", p_norm, LHBM_BRT_LEN)) {
+		bigsurf_cmd2_page_select(ctx, 2);
+		ret = mipi_dsi_dcs_read(dsi, bigsurf_lhbm_brightness_reg, p_norm, LHBM_BRT_LEN);
+		if (ret != LHBM_BRT_LEN) {
+			dev_err(ctx->dev, "failed to read lhbm brightness ret=%d\n", ret);
+			return;
+		}
 	}
 	dev_dbg(ctx->dev, "lhbm normal brightness: %*ph\n", LHBM_BRT_LEN, p_norm);
 
-	/* 0 nit */
-	grp = LHBM_OVERDRIVE_GRP_0_NIT;
-	_update_lhbm_overdrive_brightness(ctx, grp, LHBM_R, 0xB5);
-	_update_lhbm_overdrive_brightness(ctx, grp, LHBM_G, 0x85);
-	_update_lhbm_overdrive_brightness(ctx, grp, LHBM_B, 0xBA);
-	/* 0-15 nit */
-	grp = LHBM_OVERDRIVE_GRP_15_NIT;
-	_update_lhbm_overdrive_brightness(ctx, grp, LHBM_R, 0x6E);
-	_update_lhbm_overdrive_brightness(ctx, grp, LHBM_G, 0x5A);
-	_update_lhbm_overdrive_brightness(ctx, grp, LHBM_B, 0x78);
-	/* 15-200 nit */
-	grp = LHBM_OVERDRIVE_GRP_200_NIT;
-	_update_lhbm_overdrive_brightness(ctx, grp, LHBM_R, 0x46);
-	_update_lhbm_overdrive_brightness(ctx, grp, LHBM_G, 0x32);
-	_update_lhbm_overdrive_brightness(ctx, grp, LHBM_B, 0x50);
+	ret = lhbm_od_init(&ctl->od, &bigsurf_lhbm_od_desc, p_norm);
+	if (ret) {
+		dev_err(ctx->dev, "failed to init lhbm overdrive ret=%d\n", ret);
+		return;
+	}
 
 	for (grp = 0; grp < LHBM_OVERDRIVE_GRP_MAX; grp++)
 		dev_dbg(ctx->dev, "lhbm overdrive brightness[%d]: %*ph\n",
-			grp, LHBM_BRT_LEN, spanel->lhbm_ctl.brt_overdrive[grp]);
+			grp, LHBM_BRT_LEN, ctl->od.cmd[grp] + 1);
 }
 
 static void bigsurf_panel_init(struct exynos_panel *ctx)
 {
 	struct bigsurf_panel *spanel = to_spanel(ctx);
+#ifdef CONFIG_DEBUG_FS
 	struct dentry *csroot = ctx->debugfs_cmdset_entry;
 
 	exynos_panel_debugfs_create_cmdset(ctx, csroot, &bigsurf_init_cmd_set, "init");
+	debugfs_create_u16("lhbm_comp_hysteresis", 0644, ctx->debugfs_entry,
+			   &spanel->lhbm_comp.hysteresis);
+	debugfs_create_u32("lhbm_comp_min_interval_ms", 0644, ctx->debugfs_entry,
+			   &spanel->lhbm_comp.min_interval_ms);
+	debugfs_create_u32("lhbm_comp_crossings", 0444, ctx->debugfs_entry,
+			   &spanel->lhbm_comp.crossings);
+	debugfs_create_u32("lhbm_comp_updates", 0444, ctx->debugfs_entry,
+			   &spanel->lhbm_comp.updates);
+	panel_residency_debugfs_init(&spanel->residency, ctx->debugfs_entry);
+	debugfs_create_u16("binned_lp_hysteresis", 0644, ctx->debugfs_entry,
+			   &spanel->binned_lp_hysteresis);
+	debugfs_create_bool("aod_continuous", 0644, ctx->debugfs_entry,
+			    &spanel->aod_continuous);
+#endif
 	bigsurf_dimming_frame_setting(ctx, BIGSURF_DIMMING_FRAME);
 	bigsurf_lhbm_brightness_init(ctx);
 	spanel->panel_brightness = exynos_panel_get_brightness(ctx);
 }
 
+static int bigsurf_disable(struct drm_panel *panel)
+{
+	struct exynos_panel *ctx = container_of(panel, struct exynos_panel, panel);
+	struct bigsurf_panel *spanel = to_spanel(ctx);
+	int ret;
+
+	/*
+	 * don't wait for the works here, they take mode_lock; once the panel is
+	 * disabled they find it inactive and don't send anything
+	 */
+	cancel_delayed_work(&spanel->lhbm_comp.work);
+	bigsurf_cancel_idle_exit_dimming(ctx);
+
+	/* sends bigsurf_off_cmd_set */
+	ret = exynos_panel_disable(panel);
+	if (ret)
+		return ret;
+
+	/* the sleep in settle time overlaps with DPU and DSIM teardown */
+	spanel->power_off_ts = ktime_add_ms(ktime_get(), BIGSURF_SLEEP_IN_DELAY_MS);
+	panel_residency_sample(ctx, &spanel->residency, 0);
+
+	return 0;
+}
+
+static int bigsurf_unprepare(struct drm_panel *panel)
+{
+	struct exynos_panel *ctx = container_of(panel, struct exynos_panel, panel);
+	struct bigsurf_panel *spanel = to_spanel(ctx);
+
+	bigsurf_wait_for_deadline(ctx, spanel->power_off_ts);
+	spanel->power_off_ts = 0;
+
+	return exynos_panel_unprepare(panel);
+}
+
+static void bigsurf_cancel_work(void *data)
+{
+	struct bigsurf_panel *spanel = data;
+
+	cancel_delayed_work_sync(&spanel->lhbm_comp.work);
+	hrtimer_cancel(&spanel->idle_exit_dimming_timer);
+	cancel_work_sync(&spanel->idle_exit_dimming_work);
+}
+
 static int bigsurf_panel_probe(struct mipi_dsi_device *dsi)
 {
+	const struct exynos_panel_desc *desc;
 	struct bigsurf_panel *spanel;
+	int ret;
 
 	spanel = devm_kzalloc(&dsi->dev, sizeof(*spanel), GFP_KERNEL);
 	if (!spanel)
 		return -ENOMEM;
 
-	return exynos_panel_common_init(dsi, &spanel->base);
+	spanel->cmd2_page = BIGSURF_CMD2_PAGE_UNKNOWN;
+	panel_residency_init(&spanel->residency);
+	spanel->binned_lp_hysteresis = BINNED_LP_HYSTERESIS_DEFAULT;
+	spanel->aod_continuous = false;
+	spanel->lhbm_comp.hysteresis = LHBM_COMPENSATION_HYSTERESIS_DEFAULT;
+	spanel->lhbm_comp.min_interval_ms = LHBM_COMPENSATION_MIN_INTERVAL_MS_DEFAULT;
+	INIT_DELAYED_WORK(&spanel->lhbm_comp.work, bigsurf_lhbm_comp_work);
+	INIT_WORK(&spanel->idle_exit_dimming_work, bigsurf_idle_exit_dimming_work);
+	hrtimer_init(&spanel->idle_exit_dimming_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	spanel->idle_exit_dimming_timer.function = bigsurf_idle_exit_dimming_timer;
+
+	desc = of_device_get_match_data(&dsi->dev);
+	ret = panel_dsc_validate(&dsi->dev, desc);
+	if (ret)
+		return ret;
+	ret = panel_timing_check(&dsi->dev, desc,
+				 min(MIPI_DSI_FREQ_DEFAULT, MIPI_DSI_FREQ_ALTERNATIVE),
+				 BIGSURF_DSI_DATA_LANES);
+	if (ret)
+		return ret;
+
+	ret = exynos_panel_common_init(dsi, &spanel->base);
+	if (ret)
+		return ret;
+
+	/* devm actions run in reverse, stop the works before the panel is torn down */
+	return devm_add_action_or_reset(&dsi->dev, bigsurf_cancel_work, spanel);
 }
 
 static const struct drm_panel_funcs bigsurf_drm_funcs = {
-	.disable = exynos_panel_disable,
-	.unprepare = exynos_panel_unprepare,
+	.disable = bigsurf_disable,
+	.unprepare = bigsurf_unprepare,
 	.prepare = exynos_panel_prepare,
 	.enable = bigsurf_enable,
 	.get_modes = exynos_panel_get_modes,
@@ -1117,9 +1543,9 @@ static int bigsurf_panel_config(struct exynos_panel *ctx);
 
 static const struct exynos_panel_funcs bigsurf_exynos_funcs = {
 	.set_brightness = bigsurf_set_brightness,
-	.set_lp_mode = exynos_panel_set_lp_mode,
+	.set_lp_mode = bigsurf_set_lp_mode,
 	.set_nolp_mode = bigsurf_set_nolp_mode,
-	.set_binned_lp = exynos_panel_set_binned_lp,
+	.set_binned_lp = bigsurf_set_binned_lp,
 	.set_hbm_mode = bigsurf_set_hbm_mode,
 	.set_local_hbm_mode = bigsurf_set_local_hbm_mode,
 	.set_local_hbm_mode_post = bigsurf_set_local_hbm_mode_post,
@@ -1134,6 +1560,7 @@ static const struct exynos_panel_funcs bigsurf_exynos_funcs = {
 	.update_te2 = bigsurf_update_te2,
 	.read_id = bigsurf_read_id,
 	.atomic_check = bigsurf_atomic_check,
+	.commit_done = bigsurf_commit_done,
 	.pre_update_ffc = bigsurf_pre_update_ffc,
 	.update_ffc = bigsurf_update_ffc,
 	.rr_need_te_high = bigsurf_rr_need_te_high,
@@ -1244,7 +1671,7 @@ static const struct exynos_brightness_configuration bigsurf_btr_configs[] = {
 	},
 };
 
-struct exynos_panel_desc google_bigsurf = {
+static const struct exynos_panel_desc google_bigsurf = {
 	.data_lane_cnt = 4,
 	/* supported HDR format bitmask : 1(DOLBY_VISION), 2(HDR10), 3(HLG) */
 	.hdr_formats = BIT(2) | BIT(3),
@@ -1280,18 +1707,25 @@ struct exynos_panel_desc google_bigsurf = {
 
 static int bigsurf_panel_config(struct exynos_panel *ctx)
 {
+	struct exynos_panel_desc *desc;
 	int ret;
 
 	exynos_panel_model_init(ctx, PROJECT, 0);
 
-	ret = exynos_panel_init_brightness(&google_bigsurf,
+	/* brightness limits depend on the panel revision, don't write the shared desc */
+	desc = devm_kmemdup(ctx->dev, ctx->desc, sizeof(*desc), GFP_KERNEL);
+	if (!desc)
+		return -ENOMEM;
+	ctx->desc = desc;
+
+	ret = exynos_panel_init_brightness(desc,
 						bigsurf_btr_configs,
 						ARRAY_SIZE(bigsurf_btr_configs),
 						ctx->panel_rev);
 
 	if (ctx->panel_rev == PANEL_REV_EVT1) {
-		google_bigsurf.min_brightness = 268;
-		google_bigsurf.max_brightness = 4095;
+		desc->min_brightness = 268;
+		desc->max_brightness = 4095;
 	}
 
 	return ret;
@@ -1309,6 +1743,7 @@ static struct mipi_dsi_driver exynos_panel_driver = {
 	.driver = {
 		.name = "panel-google-bigsurf",
 		.of_match_table = exynos_panel_of_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 module_mipi_dsi_driver(exynos_panel_driver);
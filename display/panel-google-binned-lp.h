@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Binned LP helpers shared by Google panels.
+ *
+ * Copyright (c) 2023 Google LLC
+ */
+
+#ifndef _PANEL_GOOGLE_BINNED_LP_H_
+#define _PANEL_GOOGLE_BINNED_LP_H_
+
+#include <linux/types.h>
+
+#include "panel/panel-samsung-drv.h"
+
+/* brightness levels the ambient light has to move past a bin threshold to switch bins */
+#define BINNED_LP_HYSTERESIS_DEFAULT	64
+
+/**
+ * binned_lp_hysteresis - adjust a brightness so the current bin is kept near its edges
+ * @ctx: panel
+ * @br: requested brightness
+ * @hysteresis: brightness levels past a threshold before leaving the current bin
+ *
+ * The AOD brightness follows ambient light, which tends to hover around a bin
+ * threshold and makes the panel flip between bins, each switch being a visible
+ * brightness step and a command transfer. The "off" bin (brightness 0) is
+ * always entered and left right away.
+ *
+ * Return: brightness to pass to exynos_panel_set_binned_lp().
+ */
+static inline u16 binned_lp_hysteresis(const struct exynos_panel *ctx, u16 br, u16 hysteresis)
+{
+	const struct exynos_binned_lp *cur = ctx->current_binned_lp;
+	const struct exynos_binned_lp *bins = ctx->desc->binned_lp;
+	const int num = ctx->desc->num_binned_lp;
+	int i;
+
+	if (!cur || !bins || !br || !hysteresis)
+		return br;
+
+	i = cur - bins;
+	if (i < 0 || i >= num)
+		return br;
+
+	/* moving up into the next bin */
+	if (i + 1 < num && cur->bl_threshold && br > cur->bl_threshold &&
+	    br <= cur->bl_threshold + hysteresis)
+		return cur->bl_threshold;
+
+	/* moving down into the previous bin */
+	if (i > 0 && bins[i - 1].bl_threshold && br <= bins[i - 1].bl_threshold &&
+	    br + hysteresis > bins[i - 1].bl_threshold)
+		return bins[i - 1].bl_threshold + 1;
+
+	return br;
+}
+
+#endif /* _PANEL_GOOGLE_BINNED_LP_H_ */
@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Panel calibration handed over by the bootloader, shared by Google panels.
+ *
+ * The bootloader already reads most OTP values of the panel. It can pass them
+ * in the panel DT node as a u8 array property <name> along with a u32 property
+ * <name>-crc holding the crc32 of the array, so drivers can skip the DSI reads.
+ *
+ * Copyright (c) 2023 Google LLC
+ */
+
+#ifndef _PANEL_GOOGLE_CALIB_H_
+#define _PANEL_GOOGLE_CALIB_H_
+
+#include <linux/crc32.h>
+#include <linux/device.h>
+#include <linux/kernel.h>
+#include <linux/of.h>
+
+#define PANEL_CALIB_PROP_NAME_LEN	64
+
+/**
+ * panel_calib_get - get a calibration value from the DT handoff
+ * @dev: panel device
+ * @name: property name
+ * @buf: destination, its content is undefined on failure
+ * @len: expected length of the value
+ *
+ * Return: 0 if the value is present, has the expected length and matches its
+ * checksum, a negative error code otherwise. Callers fall back to reading the
+ * value from the panel on any error.
+ */
+static inline int panel_calib_get(struct device *dev, const char *name, u8 *buf, size_t len)
+{
+	char crc_name[PANEL_CALIB_PROP_NAME_LEN];
+	u32 crc;
+	int ret;
+
+	if (!dev->of_node || of_property_count_u8_elems(dev->of_node, name) != len)
+		return -ENOENT;
+
+	snprintf(crc_name, sizeof(crc_name), "%s-crc", name);
+	if (of_property_read_u32(dev->of_node, crc_name, &crc))
+		return -ENOENT;
+
+	ret = of_property_read_u8_array(dev->of_node, name, buf, len);
+	if (ret)
+		return ret;
+
+	if ((crc32_le(~0, buf, len) ^ ~0) != crc) {
+		dev_warn(dev, "%s: checksum mismatch, reading from panel\n", name);
+		return -EBADMSG;
+	}
+
+	dev_dbg(dev, "%s: using bootloader value\n", name);
+
+	return 0;
+}
+
+#endif /* _PANEL_GOOGLE_CALIB_H_ */
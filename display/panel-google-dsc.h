@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * DSC configuration checks shared by Google panels.
+ *
+ * DSC configurations are hand written tables where the rate control values
+ * derived from the slice geometry and bit rate are filled in as well. With
+ * CONFIG_DRM_PANEL_GOOGLE_MODE_CHECKS they are recomputed at probe time and a
+ * stale value fails the probe, so a new or edited configuration can be checked
+ * on a development build. Production builds compile the check out.
+ *
+ * Copyright (c) 2023 Google LLC
+ */
+
+#ifndef _PANEL_GOOGLE_DSC_H_
+#define _PANEL_GOOGLE_DSC_H_
+
+#include <drm/drm_dsc.h>
+#include <linux/device.h>
+#include <linux/errno.h>
+
+#include "panel/panel-samsung-drv.h"
+
+#if IS_ENABLED(CONFIG_DRM_PANEL_GOOGLE_MODE_CHECKS)
+#define PANEL_DSC_CHECK(dev, name, cfg, calc, field)					\
+({											\
+	const bool __ok = (cfg)->field == (calc)->field;				\
+											\
+	if (!__ok)									\
+		dev_err(dev, "%s: dsc " #field " is %u, expected %u\n", name,		\
+			(u32)(cfg)->field, (u32)(calc)->field);				\
+	__ok;										\
+})
+
+/**
+ * panel_dsc_validate_mode - check the DSC configuration of a mode
+ * @dev: panel device
+ * @pmode: mode
+ *
+ * Configurations which only override a few values (no pic_width) are completed
+ * by the DPU, only their slice geometry is checked.
+ *
+ * Return: true if the configuration is consistent.
+ */
+static inline bool panel_dsc_validate_mode(struct device *dev,
+					   const struct exynos_panel_mode *pmode)
+{
+	const struct exynos_display_dsc *dsc = &pmode->exynos_mode.dsc;
+	const struct drm_display_mode *mode = &pmode->mode;
+	const struct drm_dsc_config *cfg = dsc->cfg;
+	struct drm_dsc_config calc;
+	bool ok = true;
+	int ret;
+
+	if (!dsc->enabled)
+		return true;
+
+	if (!dsc->slice_count || !dsc->slice_height || mode->hdisplay % dsc->slice_count ||
+	    mode->vdisplay % dsc->slice_height) {
+		dev_err(dev, "%s: %ux%u doesn't split into %u slices of height %u\n", mode->name,
+			mode->hdisplay, mode->vdisplay, dsc->slice_count, dsc->slice_height);
+		return false;
+	}
+
+	if (!cfg || !cfg->pic_width)
+		return true;
+
+	if (cfg->pic_width != mode->hdisplay || cfg->pic_height != mode->vdisplay ||
+	    cfg->slice_width * dsc->slice_count != mode->hdisplay ||
+	    cfg->slice_height != dsc->slice_height) {
+		dev_err(dev, "%s: dsc picture %ux%u slice %ux%u doesn't match the mode\n",
+			mode->name, cfg->pic_width, cfg->pic_height, cfg->slice_width,
+			cfg->slice_height);
+		return false;
+	}
+
+	calc = *cfg;
+	ret = drm_dsc_compute_rc_parameters(&calc);
+	if (ret) {
+		dev_err(dev, "%s: invalid dsc rc parameters (%d)\n", mode->name, ret);
+		return false;
+	}
+
+	ok &= PANEL_DSC_CHECK(dev, mode->name, cfg, &calc, slice_chunk_size);
+	ok &= PANEL_DSC_CHECK(dev, mode->name, cfg, &calc, initial_scale_value);
+	ok &= PANEL_DSC_CHECK(dev, mode->name, cfg, &calc, scale_decrement_interval);
+	ok &= PANEL_DSC_CHECK(dev, mode->name, cfg, &calc, scale_increment_interval);
+	ok &= PANEL_DSC_CHECK(dev, mode->name, cfg, &calc, nfl_bpg_offset);
+	ok &= PANEL_DSC_CHECK(dev, mode->name, cfg, &calc, slice_bpg_offset);
+	ok &= PANEL_DSC_CHECK(dev, mode->name, cfg, &calc, final_offset);
+
+	return ok;
+}
+
+/**
+ * panel_dsc_validate - check the DSC configuration of all modes of a panel
+ * @dev: panel device
+ * @desc: panel description
+ *
+ * Return: 0 if all configurations are consistent, -EINVAL otherwise.
+ */
+static inline int panel_dsc_validate(struct device *dev, const struct exynos_panel_desc *desc)
+{
+	const size_t lp_count = desc->lp_mode_count ?: (desc->lp_mode ? 1 : 0);
+	bool ok = true;
+	size_t i;
+
+	for (i = 0; i < desc->num_modes; i++)
+		ok &= panel_dsc_validate_mode(dev, &desc->modes[i]);
+	for (i = 0; i < lp_count; i++)
+		ok &= panel_dsc_validate_mode(dev, &desc->lp_mode[i]);
+
+	return ok ? 0 : -EINVAL;
+}
+#else
+static inline int panel_dsc_validate(struct device *dev, const struct exynos_panel_desc *desc)
+{
+	return 0;
+}
+#endif /* CONFIG_DRM_PANEL_GOOGLE_MODE_CHECKS */
+
+#endif /* _PANEL_GOOGLE_DSC_H_ */
@@ -11,6 +11,7 @@
 
 #include <drm/drm_vblank.h>
 #include <linux/debugfs.h>
+#include <linux/input.h>
 #include <linux/module.h>
 #include <linux/of_platform.h>
 #include <linux/thermal.h>
@@ -19,6 +20,12 @@
 #include "include/trace/dpu_trace.h"
 #include "include/trace/panel_trace.h"
 #include "panel/panel-samsung-drv.h"
+#include "panel-google-binned-lp.h"
+#include "panel-google-calib.h"
+#include "panel-google-dsc.h"
+#include "panel-google-lhbm-od.h"
+#include "panel-google-residency.h"
+#include "panel-google-timing.h"
 
 /**
  * enum hk3_panel_feature - features supported by this panel
@@ -95,10 +102,8 @@ enum hk3_material {
 struct hk3_lhbm_ctl {
 	/** @brt_normal: normal LHBM brightness parameters */
 	u8 brt_normal[LHBM_BRT_LEN];
-	/** @brt_overdrive: overdrive LHBM brightness parameters */
-	u8 brt_overdrive[LHBM_OVERDRIVE_GRP_MAX][LHBM_BRT_LEN];
-	/** @overdrived: whether LHBM is overdrived */
-	bool overdrived;
+	/** @od: overdrive state and precomputed brightness commands */
+	struct lhbm_od od;
 	/** @hist_roi_configured: whether LHBM histogram configuration is done */
 	bool hist_roi_configured;
 };
@@ -139,6 +144,33 @@ struct hk3_panel {
 	 *			if 0 it means that auto mode is not enabled
 	 */
 	u32 auto_mode_vrefresh;
+	/**
+	 * @content_cadence: frame rate of the content declared by userspace, e.g. 24 for
+	 *		     film. Auto mode only idles at rates which are a multiple of it.
+	 *		     0 if no cadence is declared. It's cleared on disable, userspace
+	 *		     declares it again once the display is back on.
+	 */
+	u32 content_cadence;
+	/**
+	 * @touch_ee: early exit from auto mode idle on touch down, ahead of the frame
+	 *	      the touch will cause
+	 */
+	struct {
+		/** @touch_ee.np: touch controller linked by the "touch" DT property */
+		struct device_node *np;
+		/** @touch_ee.handler: input handler bound to the touch controller */
+		struct input_handler handler;
+		/** @touch_ee.work: sends the early exit, input events can't sleep */
+		struct work_struct work;
+		/** @touch_ee.last_ts: time of the last scheduled early exit */
+		ktime_t last_ts;
+		/** @touch_ee.min_interval_ms: minimum time between two early exits */
+		u32 min_interval_ms;
+		/** @touch_ee.count: number of early exits triggered by touch */
+		u32 count;
+		/** @touch_ee.throttled: number of touch downs dropped by @min_interval_ms */
+		u32 throttled;
+	} touch_ee;
 	/** @force_changeable_te: force changeable TE (instead of fixed) during early exit */
 	bool force_changeable_te;
 	/** @force_changeable_te2: force changeable TE (instead of fixed) for monitoring refresh rate */
@@ -177,6 +209,10 @@ struct hk3_panel {
 	 *	       cannot block the main thread.
 	 */
 	bool read_vreg;
+	/** @residency: time spent in each power state */
+	struct panel_residency residency;
+	/** @binned_lp_hysteresis: brightness levels to move past a bin threshold in AOD */
+	u16 binned_lp_hysteresis;
 };
 
 #define to_spanel(ctx) container_of(ctx, struct hk3_panel, base)
@@ -325,9 +361,11 @@ static const struct drm_dsc_config fhd_pps_config = {
 #define HK3_TE_USEC_60HZ_HS 8500
 #define HK3_TE_USEC_60HZ_NS 546
 #define HK3_TE_PERIOD_DELTA_TOLERANCE_USEC 2000
+#define HK3_TOUCH_EARLY_EXIT_MIN_INTERVAL_MS 100
 
 #define MIPI_DSI_FREQ_DEFAULT 1368
 #define MIPI_DSI_FREQ_ALTERNATIVE 1346
+#define HK3_DSI_DATA_LANES 4
 
 #define PROJECT "HK3"
 
@@ -336,6 +374,51 @@ static const u8 lock_cmd_f0[]   = { 0xF0, 0xA5, 0xA5 };
 static const u8 freq_update[] = { 0xF7, 0x0F };
 static const u8 lhbm_brightness_index[] = { 0xB0, 0x03, 0x21, 0x95 };
 static const u8 lhbm_brightness_reg = 0x95;
+
+static const struct lhbm_od_channel hk3_lhbm_od_channels[] = {
+	{ LHBM_OD_FINE_COARSE, LHBM_R_FINE, LHBM_R_COARSE, 0xFF },
+	{ LHBM_OD_FINE_COARSE, LHBM_G_FINE, LHBM_GB_COARSE, 0xF0 },
+	{ LHBM_OD_FINE_COARSE, LHBM_B_FINE, LHBM_GB_COARSE, 0x0F },
+};
+
+/* fine_0, fine_1, coarse_0, coarse_1 for R, G and B */
+static const struct lhbm_od_offset
+hk3_lhbm_od_offsets[LHBM_OVERDRIVE_GRP_MAX][LHBM_OD_MAX_CHANNELS] = {
+	/* 0 nit */
+	[LHBM_OVERDRIVE_GRP_0_NIT] = {
+		{ 0x00, 0x00, 0x01, 0x01 },
+		{ 0x00, 0x00, 0x10, 0x10 },
+		{ 0x5C, 0x79, 0x01, 0x02 },
+	},
+	/* 0 - 6 nits */
+	[LHBM_OVERDRIVE_GRP_6_NIT] = {
+		{ 0x63, 0x7A, 0x00, 0x01 },
+		{ 0x70, 0x80, 0x00, 0x10 },
+		{ 0x90, 0x43, 0x00, 0x01 },
+	},
+	/* 6 - 100 nits */
+	[LHBM_OVERDRIVE_GRP_50_NIT] = {
+		{ 0x45, 0x8F, 0x00, 0x01 },
+		{ 0x55, 0x98, 0x00, 0x10 },
+		{ 0x75, 0x58, 0x00, 0x01 },
+	},
+	/* 100 - 300 nits */
+	[LHBM_OVERDRIVE_GRP_300_NIT] = {
+		{ 0x44, 0xA2, 0x00, 0x01 },
+		{ 0x41, 0xAC, 0x00, 0x10 },
+		{ 0x55, 0x78, 0x00, 0x01 },
+	},
+};
+
+static const struct lhbm_od_desc hk3_lhbm_od_desc = {
+	.reg = 0x95, /* lhbm_brightness_reg */
+	.brt_len = LHBM_BRT_LEN,
+	.channels = hk3_lhbm_od_channels,
+	.num_channels = ARRAY_SIZE(hk3_lhbm_od_channels),
+	.offsets = hk3_lhbm_od_offsets,
+	.num_groups = LHBM_OVERDRIVE_GRP_MAX,
+};
+
 static const u8 pixel_off[] = { 0x22 };
 static const u8 sync_begin[] = { 0xE4, 0x00, 0x2C, 0x2C, 0xA2, 0x00, 0x00 };
 static const u8 sync_end[] = { 0xE4, 0x00, 0x2C, 0x2C, 0x82, 0x00, 0x00 };
@@ -510,23 +593,34 @@ static inline bool is_auto_mode_allowed(struct exynos_panel *ctx)
 	return ctx->panel_idle_enabled;
 }
 
+/* idle rates auto frame insertion can step down to, in ascending order */
+static const u32 hk3_idle_vrefresh_steps[] = { 1, 10, 30 };
+
 static u32 hk3_get_min_idle_vrefresh(struct exynos_panel *ctx,
 				     const struct exynos_panel_mode *pmode)
 {
+	const struct hk3_panel *spanel = to_spanel(ctx);
 	const int vrefresh = drm_mode_vrefresh(&pmode->mode);
+	const u32 cadence = spanel->content_cadence;
 	int min_idle_vrefresh = ctx->min_vrefresh;
+	int i;
 
 	if ((min_idle_vrefresh < 0) || !is_auto_mode_allowed(ctx))
 		return 0;
 
-	if (min_idle_vrefresh <= 1)
-		min_idle_vrefresh = 1;
-	else if (min_idle_vrefresh <= 10)
-		min_idle_vrefresh = 10;
-	else if (min_idle_vrefresh <= 30)
-		min_idle_vrefresh = 30;
-	else
+	/*
+	 * with a declared content cadence, only idle at a multiple of it so that every
+	 * content frame is shown for the same number of panel frames
+	 */
+	for (i = 0; i < ARRAY_SIZE(hk3_idle_vrefresh_steps); i++) {
+		const u32 step = hk3_idle_vrefresh_steps[i];
+
+		if (step >= min_idle_vrefresh && (!cadence || !(step % cadence)))
+			break;
+	}
+	if (i == ARRAY_SIZE(hk3_idle_vrefresh_steps))
 		return 0;
+	min_idle_vrefresh = hk3_idle_vrefresh_steps[i];
 
 	if (min_idle_vrefresh >= vrefresh) {
 		dev_dbg(ctx->dev, "min idle vrefresh (%d) higher than target (%d)\n",
@@ -539,6 +633,14 @@ static u32 hk3_get_min_idle_vrefresh(struct exynos_panel *ctx,
 	return min_idle_vrefresh;
 }
 
+static void hk3_update_residency(struct exynos_panel *ctx)
+{
+	struct hk3_panel *spanel = to_spanel(ctx);
+
+	panel_residency_sample(ctx, &spanel->residency,
+			       is_panel_active(ctx) ? spanel->hw_vrefresh : 0);
+}
+
 static void hk3_set_panel_feat(struct exynos_panel *ctx,
 	const u32 vrefresh, const u32 idle_vrefresh, const unsigned long *feat, bool enforce)
 {
@@ -854,6 +956,8 @@ static void hk3_set_panel_feat(struct exynos_panel *ctx,
 
 	EXYNOS_DCS_BUF_ADD_SET(ctx, freq_update);
 	EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, lock_cmd_f0);;
+
+	hk3_update_residency(ctx);
 }
 
 /**
@@ -877,6 +981,12 @@ static void hk3_update_panel_feat(struct exynos_panel *ctx, u32 vrefresh, bool e
 	hk3_set_panel_feat(ctx, vrefresh, spanel->auto_mode_vrefresh, spanel->feat, enforce);
 }
 
+/* wake up pollers of te_rate, the effective TE rate may have changed */
+static inline void hk3_te_rate_notify(struct exynos_panel *ctx)
+{
+	sysfs_notify(&ctx->dev->kobj, NULL, "te_rate");
+}
+
 static void hk3_update_refresh_mode(struct exynos_panel *ctx,
 					const struct exynos_panel_mode *pmode,
 					const u32 idle_vrefresh)
@@ -920,6 +1030,8 @@ static void hk3_update_refresh_mode(struct exynos_panel *ctx,
 	hk3_update_panel_feat(ctx, vrefresh, false);
 
 	schedule_work(&ctx->state_notify);
+	hk3_te_rate_notify(ctx);
+	hk3_update_residency(ctx);
 
 	dev_dbg(ctx->dev, "%s: display state is notified\n", __func__);
 }
@@ -1029,6 +1141,8 @@ static bool hk3_set_self_refresh(struct exynos_panel *ctx, bool enable)
 		/* set 1Hz while self refresh is active, otherwise clear it */
 		ctx->panel_idle_vrefresh = enable ? 1 : 0;
 		schedule_work(&ctx->state_notify);
+		hk3_te_rate_notify(ctx);
+		hk3_update_residency(ctx);
 		return false;
 	}
 
@@ -1301,6 +1415,14 @@ static void hk3_set_acl_mode(struct exynos_panel *ctx, enum exynos_acl_mode mode
 	}
 }
 
+static void hk3_set_binned_lp(struct exynos_panel *ctx, const u16 brightness)
+{
+	struct hk3_panel *spanel = to_spanel(ctx);
+
+	exynos_panel_set_binned_lp(ctx, binned_lp_hysteresis(ctx, brightness,
+							     spanel->binned_lp_hysteresis));
+}
+
 static int hk3_set_brightness(struct exynos_panel *ctx, u16 br)
 {
 	int ret;
@@ -1318,6 +1440,7 @@ static int hk3_set_brightness(struct exynos_panel *ctx, u16 br)
 		funcs = ctx->desc->exynos_panel_func;
 		if (funcs && funcs->set_binned_lp)
 			funcs->set_binned_lp(ctx, br);
+		hk3_update_residency(ctx);
 		return 0;
 	}
 
@@ -1339,6 +1462,7 @@ static int hk3_set_brightness(struct exynos_panel *ctx, u16 br)
 	if (!ret) {
 		spanel->hw_dbv = br;
 		hk3_set_acl_mode(ctx, ctx->acl_mode);
+		hk3_update_residency(ctx);
 	}
 
 	return ret;
@@ -1507,6 +1631,7 @@ static void hk3_set_lp_mode(struct exynos_panel *ctx, const struct exynos_panel_
 
 	spanel->hw_vrefresh = 30;
 	spanel->read_vreg = true;
+	hk3_update_residency(ctx);
 
 	DPU_ATRACE_END(__func__);
 
@@ -1805,6 +1930,9 @@ static int hk3_disable(struct drm_panel *panel)
 	spanel->hw_acl_setting = 0;
 	spanel->hw_za_enabled = false;
 	spanel->hw_dbv = 0;
+	/* the content playing before the display went off is gone */
+	spanel->content_cadence = 0;
+	panel_residency_sample(ctx, &spanel->residency, 0);
 
 	return 0;
 }
@@ -1830,7 +1958,11 @@ static void hk3_update_idle_state(struct exynos_panel *ctx)
 	s64 delta_us;
 	struct hk3_panel *spanel = to_spanel(ctx);
 
-	ctx->panel_idle_vrefresh = 0;
+	if (ctx->panel_idle_vrefresh) {
+		hk3_te_rate_notify(ctx);
+		ctx->panel_idle_vrefresh = 0;
+		hk3_update_residency(ctx);
+	}
 	if (!test_bit(FEAT_FRAME_AUTO, spanel->feat))
 		return;
 
@@ -1859,10 +1991,166 @@ static void hk3_update_idle_state(struct exynos_panel *ctx)
 	DPU_ATRACE_END(__func__);
 }
 
+static void hk3_touch_ee_work(struct work_struct *work)
+{
+	struct hk3_panel *spanel = container_of(work, struct hk3_panel, touch_ee.work);
+	struct exynos_panel *ctx = &spanel->base;
+
+	mutex_lock(&ctx->mode_lock);
+	/*
+	 * Only the early exit command is sent: a touch may not produce a frame, so
+	 * auto mode stays on and the panel lowers the rate again by itself. Turning
+	 * auto mode off is left to the commit path.
+	 */
+	if (is_panel_active(ctx) && ctx->current_mode &&
+	    !ctx->current_mode->exynos_mode.is_lp_mode &&
+	    ctx->mode_in_progress == MODE_DONE && ctx->panel_idle_enabled &&
+	    ctx->panel_idle_vrefresh && test_bit(FEAT_FRAME_AUTO, spanel->feat) &&
+	    ktime_us_delta(ktime_get(), ctx->last_commit_ts) >= EARLY_EXIT_THRESHOLD_US) {
+		/* triggering early exit causes a switch to 120hz */
+		ctx->last_mode_set_ts = ktime_get();
+
+		DPU_ATRACE_BEGIN(__func__);
+		EXYNOS_DCS_BUF_ADD_SET(ctx, unlock_cmd_f0);
+		EXYNOS_DCS_BUF_ADD_SET(ctx, freq_update);
+		EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, lock_cmd_f0);
+		spanel->touch_ee.count++;
+		DPU_ATRACE_END(__func__);
+	}
+	mutex_unlock(&ctx->mode_lock);
+}
+
+static void hk3_touch_ee_event(struct input_handle *handle, unsigned int type,
+			       unsigned int code, int value)
+{
+	struct hk3_panel *spanel = handle->private;
+	const ktime_t now = ktime_get();
+
+	if (type != EV_KEY || code != BTN_TOUCH || !value)
+		return;
+
+	if (ktime_ms_delta(now, spanel->touch_ee.last_ts) < spanel->touch_ee.min_interval_ms) {
+		spanel->touch_ee.throttled++;
+		return;
+	}
+
+	spanel->touch_ee.last_ts = now;
+	schedule_work(&spanel->touch_ee.work);
+}
+
+static bool hk3_touch_ee_match(struct input_handler *handler, struct input_dev *dev)
+{
+	struct hk3_panel *spanel = container_of(handler, struct hk3_panel, touch_ee.handler);
+	struct device *d;
+
+	for (d = dev->dev.parent; d; d = d->parent) {
+		if (d->of_node == spanel->touch_ee.np)
+			return true;
+	}
+
+	return false;
+}
+
+static int hk3_touch_ee_connect(struct input_handler *handler, struct input_dev *dev,
+				const struct input_device_id *id)
+{
+	struct hk3_panel *spanel = container_of(handler, struct hk3_panel, touch_ee.handler);
+	struct input_handle *handle;
+	int ret;
+
+	handle = kzalloc(sizeof(*handle), GFP_KERNEL);
+	if (!handle)
+		return -ENOMEM;
+
+	handle->dev = dev;
+	handle->handler = handler;
+	handle->name = handler->name;
+	handle->private = spanel;
+
+	ret = input_register_handle(handle);
+	if (ret)
+		goto err_free;
+
+	ret = input_open_device(handle);
+	if (ret)
+		goto err_unregister;
+
+	dev_info(spanel->base.dev, "touch early exit bound to %s\n", dev_name(&dev->dev));
+
+	return 0;
+
+err_unregister:
+	input_unregister_handle(handle);
+err_free:
+	kfree(handle);
+	return ret;
+}
+
+static void hk3_touch_ee_disconnect(struct input_handle *handle)
+{
+	input_close_device(handle);
+	input_unregister_handle(handle);
+	kfree(handle);
+}
+
+static const struct input_device_id hk3_touch_ee_ids[] = {
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT | INPUT_DEVICE_ID_MATCH_KEYBIT,
+		.evbit = { BIT_MASK(EV_KEY) },
+		.keybit = { [BIT_WORD(BTN_TOUCH)] = BIT_MASK(BTN_TOUCH) },
+	},
+	{ },
+};
+
+static void hk3_touch_ee_unregister(void *data)
+{
+	struct hk3_panel *spanel = data;
+
+	input_unregister_handler(&spanel->touch_ee.handler);
+	cancel_work_sync(&spanel->touch_ee.work);
+	of_node_put(spanel->touch_ee.np);
+}
+
+static void hk3_touch_ee_register(struct hk3_panel *spanel)
+{
+	struct device *dev = spanel->base.dev;
+	struct input_handler *handler = &spanel->touch_ee.handler;
+	int ret;
+
+	spanel->touch_ee.np = of_parse_phandle(dev->of_node, "touch", 0);
+	if (!spanel->touch_ee.np)
+		return;
+
+	spanel->touch_ee.min_interval_ms = HK3_TOUCH_EARLY_EXIT_MIN_INTERVAL_MS;
+	INIT_WORK(&spanel->touch_ee.work, hk3_touch_ee_work);
+
+	handler->name = dev_name(dev);
+	handler->event = hk3_touch_ee_event;
+	handler->match = hk3_touch_ee_match;
+	handler->connect = hk3_touch_ee_connect;
+	handler->disconnect = hk3_touch_ee_disconnect;
+	handler->id_table = hk3_touch_ee_ids;
+
+	ret = input_register_handler(handler);
+	if (ret) {
+		dev_warn(dev, "failed to register touch handler (%d)\n", ret);
+		of_node_put(spanel->touch_ee.np);
+		spanel->touch_ee.np = NULL;
+		return;
+	}
+
+	ret = devm_add_action_or_reset(dev, hk3_touch_ee_unregister, spanel);
+	if (ret)
+		dev_warn(dev, "failed to add touch handler cleanup (%d)\n", ret);
+}
+
 static void hk3_commit_done(struct exynos_panel *ctx)
 {
 	struct hk3_panel *spanel = to_spanel(ctx);
 
+	/* panel state is only set active once enable is done, pick it up here */
+	hk3_update_residency(ctx);
+
 	if (ctx->current_mode->exynos_mode.is_lp_mode)
 		return;
 
@@ -1919,6 +2207,7 @@ static void hk3_set_hbm_mode(struct exynos_panel *ctx,
 		if (IS_HBM_ON(mode))
 			hk3_write_display_mode(ctx, &pmode->mode);
 	}
+	hk3_update_residency(ctx);
 }
 
 static void hk3_set_dimming_on(struct exynos_panel *ctx,
@@ -1938,10 +2227,9 @@ static void hk3_set_local_hbm_brightness(struct exynos_panel *ctx, bool is_first
 {
 	struct hk3_panel *spanel = to_spanel(ctx);
 	struct hk3_lhbm_ctl *ctl = &spanel->lhbm_ctl;
-	const u8 *brt;
 	enum hk3_lhbm_brt_overdrive_group group = LHBM_OVERDRIVE_GRP_MAX;
-	static u8 cmd[LHBM_BRT_CMD_LEN];
-	int i;
+	u8 cmd[LHBM_BRT_CMD_LEN];
+	const u8 *od_cmd;
 
 	if (!is_local_hbm_post_enabling_supported(ctx))
 		return;
@@ -1977,19 +2265,15 @@ static void hk3_set_local_hbm_brightness(struct exynos_panel *ctx, bool is_first
 			gray, dbv, luma);
 	}
 
-	if (group < LHBM_OVERDRIVE_GRP_MAX) {
-		brt = ctl->brt_overdrive[group];
-		ctl->overdrived = true;
-	} else {
-		brt = ctl->brt_normal;
-		ctl->overdrived = false;
+	od_cmd = lhbm_od_select(&ctl->od, group);
+	if (!od_cmd) {
+		dev_err(ctx->dev, "%s: no lhbm brightness\n", __func__);
+		return;
 	}
-	cmd[0] = lhbm_brightness_reg;
-	for (i = 0; i < LHBM_BRT_LEN; i++)
-		cmd[i+1] = brt[i];
+	memcpy(cmd, od_cmd, sizeof(cmd));
 	dev_dbg(ctx->dev, "set %s brightness: [%d] %*ph\n",
-		ctl->overdrived ? "overdrive" : "normal",
-		ctl->overdrived ? group : -1, LHBM_BRT_LEN, brt);
+		lhbm_od_is_overdrived(&ctl->od) ? "overdrive" : "normal",
+		lhbm_od_is_overdrived(&ctl->od) ? group : -1, LHBM_BRT_LEN, cmd + 1);
 	EXYNOS_DCS_BUF_ADD_SET(ctx, unlock_cmd_f0);
 	EXYNOS_DCS_BUF_ADD_SET(ctx, lhbm_brightness_index);
 	EXYNOS_DCS_BUF_ADD_SET(ctx, cmd);
@@ -2013,7 +2297,7 @@ static void hk3_set_local_hbm_mode_post(struct exynos_panel *ctx)
 {
 	const struct hk3_panel *spanel = to_spanel(ctx);
 
-	if (spanel->lhbm_ctl.overdrived)
+	if (lhbm_od_is_overdrived(&spanel->lhbm_ctl.od))
 		hk3_set_local_hbm_brightness(ctx, false);
 }
 
@@ -2503,100 +2787,35 @@ static const struct exynos_panel_mode hk3_lp_modes[] = {
 #endif
 };
 
-static void hk3_calc_lhbm_od_brightness(u8 n_fine, u8 n_coarse,
-	u8 *o_fine, u8 *o_coarse,
-	u8 fine_offset_0, u8 fine_offset_1,
-	u8 coarse_offset_0, u8 coarse_offset_1)
-{
-	if (((int)n_fine + (int)fine_offset_0) <= 0xFF) {
-		*o_coarse = n_coarse + coarse_offset_0;
-		*o_fine = n_fine + fine_offset_0;
-	} else {
-		*o_coarse = n_coarse + coarse_offset_1;
-		*o_fine = n_fine - fine_offset_1;
-	}
-}
-
 static void hk3_lhbm_brightness_init(struct exynos_panel *ctx)
 {
 	struct mipi_dsi_device *dsi = to_mipi_dsi_device(ctx->dev);
 	struct hk3_panel *spanel = to_spanel(ctx);
 	struct hk3_lhbm_ctl *ctl = &spanel->lhbm_ctl;
-	int ret;
-	u8 g_coarse, b_coarse;
+	int ret, grp;
 	u8 *p_norm = ctl->brt_normal;
-	u8 *p_over;
-	enum hk3_lhbm_brt_overdrive_group grp;
 
-	EXYNOS_DCS_WRITE_TABLE(ctx, unlock_cmd_f0);
-	EXYNOS_DCS_WRITE_TABLE(ctx, lhbm_brightness_index);
-	ret = mipi_dsi_dcs_read(dsi, lhbm_brightness_reg, p_norm, LHBM_BRT_LEN);
-	EXYNOS_DCS_WRITE_TABLE(ctx, lock_cmd_f0);
-	if (ret != LHBM_BRT_LEN) {
-		dev_err(ctx->dev, "failed to read lhbm brightness ret=%d\n", ret);
-		return;
+	if (panel_calib_get(ctx->dev, "google,lhbm-brightness", p_norm, LHBM_BRT_LEN)) {
+		EXYNOS_DCS_WRITE_TABLE(ctx, unlock_cmd_f0);
+		EXYNOS_DCS_WRITE_TABLE(ctx, lhbm_brightness_index);
+		ret = mipi_dsi_dcs_read(dsi, lhbm_brightness_reg, p_norm, LHBM_BRT_LEN);
+		EXYNOS_DCS_WRITE_TABLE(ctx, lock_cmd_f0);
+		if (ret != LHBM_BRT_LEN) {
+			dev_err(ctx->dev, "failed to read lhbm brightness ret=%d\n", ret);
+			return;
+		}
 	}
 	dev_dbg(ctx->dev, "lhbm normal brightness: %*ph\n", LHBM_BRT_LEN, p_norm);
 
-	/* 0 nit */
-	grp = LHBM_OVERDRIVE_GRP_0_NIT;
-	p_over = ctl->brt_overdrive[grp];
-	hk3_calc_lhbm_od_brightness(p_norm[LHBM_R_FINE], p_norm[LHBM_R_COARSE],
-		&p_over[LHBM_R_FINE], &p_over[LHBM_R_COARSE],
-		0x00, 0x00, 0x01, 0x01);
-	hk3_calc_lhbm_od_brightness(p_norm[LHBM_G_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_G_FINE], &g_coarse,
-		0x00, 0x00, 0x10, 0x10);
-	hk3_calc_lhbm_od_brightness(p_norm[LHBM_B_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_B_FINE], &b_coarse,
-		0x5C, 0x79, 0x01, 0x02);
-	p_over[LHBM_GB_COARSE] = (g_coarse & 0xF0) | (b_coarse & 0x0F);
-
-	/* 0 - 6 nits */
-	grp = LHBM_OVERDRIVE_GRP_6_NIT;
-	p_over = ctl->brt_overdrive[grp];
-	hk3_calc_lhbm_od_brightness(p_norm[LHBM_R_FINE], p_norm[LHBM_R_COARSE],
-		&p_over[LHBM_R_FINE], &p_over[LHBM_R_COARSE],
-		0x63, 0x7A, 0x00, 0x01);
-	hk3_calc_lhbm_od_brightness(p_norm[LHBM_G_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_G_FINE], &g_coarse,
-		0x70, 0x80, 0x00, 0x10);
-	hk3_calc_lhbm_od_brightness(p_norm[LHBM_B_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_B_FINE], &b_coarse,
-		0x90, 0x43, 0x00, 0x01);
-	p_over[LHBM_GB_COARSE] = (g_coarse & 0xF0) | (b_coarse & 0x0F);
-
-	/* 6 - 100 nits */
-	grp = LHBM_OVERDRIVE_GRP_50_NIT;
-	p_over = ctl->brt_overdrive[grp];
-	hk3_calc_lhbm_od_brightness(p_norm[LHBM_R_FINE], p_norm[LHBM_R_COARSE],
-		&p_over[LHBM_R_FINE], &p_over[LHBM_R_COARSE],
-		0x45, 0x8F, 0x00, 0x01);
-	hk3_calc_lhbm_od_brightness(p_norm[LHBM_G_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_G_FINE], &g_coarse,
-		0x55, 0x98, 0x00, 0x10);
-	hk3_calc_lhbm_od_brightness(p_norm[LHBM_B_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_B_FINE], &b_coarse,
-		0x75, 0x58, 0x00, 0x01);
-	p_over[LHBM_GB_COARSE] = (g_coarse & 0xF0) | (b_coarse & 0x0F);
-
-	/* 100 - 300 nits */
-	grp = LHBM_OVERDRIVE_GRP_300_NIT;
-	p_over = ctl->brt_overdrive[grp];
-	hk3_calc_lhbm_od_brightness(p_norm[LHBM_R_FINE], p_norm[LHBM_R_COARSE],
-		&p_over[LHBM_R_FINE], &p_over[LHBM_R_COARSE],
-		0x44, 0xA2, 0x00, 0x01);
-	hk3_calc_lhbm_od_brightness(p_norm[LHBM_G_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_G_FINE], &g_coarse,
-		0x41, 0xAC, 0x00, 0x10);
-	hk3_calc_lhbm_od_brightness(p_norm[LHBM_B_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_B_FINE], &b_coarse,
-		0x55, 0x78, 0x00, 0x01);
-	p_over[LHBM_GB_COARSE] = (g_coarse & 0xF0) | (b_coarse & 0x0F);
+	ret = lhbm_od_init(&ctl->od, &hk3_lhbm_od_desc, p_norm);
+	if (ret) {
+		dev_err(ctx->dev, "failed to init lhbm overdrive ret=%d\n", ret);
+		return;
+	}
 
 	for (grp = 0; grp < LHBM_OVERDRIVE_GRP_MAX; grp++) {
 		dev_dbg(ctx->dev, "lhbm overdrive brightness[%d]: %*ph\n",
-			grp, LHBM_BRT_LEN, ctl->brt_overdrive[grp]);
+			grp, LHBM_BRT_LEN, ctl->od.cmd[grp] + 1);
 	}
 }
 
@@ -2611,6 +2830,15 @@ static void hk3_panel_init(struct exynos_panel *ctx)
 				&spanel->force_changeable_te);
 	debugfs_create_bool("force_changeable_te2", 0644, ctx->debugfs_entry,
 				&spanel->force_changeable_te2);
+	debugfs_create_u32("touch_ee_min_interval_ms", 0644, ctx->debugfs_entry,
+			   &spanel->touch_ee.min_interval_ms);
+	debugfs_create_u32("touch_ee_count", 0444, ctx->debugfs_entry,
+			   &spanel->touch_ee.count);
+	debugfs_create_u32("touch_ee_throttled", 0444, ctx->debugfs_entry,
+			   &spanel->touch_ee.throttled);
+	panel_residency_debugfs_init(&spanel->residency, ctx->debugfs_entry);
+	debugfs_create_u16("binned_lp_hysteresis", 0644, ctx->debugfs_entry,
+			   &spanel->binned_lp_hysteresis);
 	debugfs_create_bool("force_za_off", 0644, ctx->debugfs_entry,
 				&spanel->force_za_off);
 	debugfs_create_u8("hw_acl_setting", 0644, ctx->debugfs_entry,
@@ -2639,9 +2867,131 @@ static void hk3_panel_init(struct exynos_panel *ctx)
 			__func__);
 }
 
+static ssize_t content_cadence_show(struct device *dev, struct device_attribute *attr,
+				    char *buf)
+{
+	struct exynos_panel *ctx = mipi_dsi_get_drvdata(to_mipi_dsi_device(dev));
+
+	if (!ctx)
+		return -ENODEV;
+
+	return sysfs_emit(buf, "%u\n", to_spanel(ctx)->content_cadence);
+}
+
+static ssize_t content_cadence_store(struct device *dev, struct device_attribute *attr,
+				     const char *buf, size_t count)
+{
+	struct exynos_panel *ctx = mipi_dsi_get_drvdata(to_mipi_dsi_device(dev));
+	const struct exynos_panel_mode *pmode;
+	struct hk3_panel *spanel;
+	u32 cadence, idle_vrefresh;
+	int ret;
+
+	if (!ctx)
+		return -ENODEV;
+
+	ret = kstrtou32(buf, 0, &cadence);
+	if (ret)
+		return ret;
+
+	spanel = to_spanel(ctx);
+	mutex_lock(&ctx->mode_lock);
+	spanel->content_cadence = cadence;
+	pmode = ctx->current_mode;
+	if (pmode && is_panel_active(ctx) && pmode->idle_mode == IDLE_MODE_ON_INACTIVITY) {
+		idle_vrefresh = hk3_get_min_idle_vrefresh(ctx, pmode);
+		if (spanel->auto_mode_vrefresh != idle_vrefresh)
+			hk3_update_refresh_mode(ctx, pmode, idle_vrefresh);
+	}
+	mutex_unlock(&ctx->mode_lock);
+
+	dev_dbg(ctx->dev, "%s: %u\n", __func__, cadence);
+
+	return count;
+}
+static DEVICE_ATTR_RW(content_cadence);
+
+/*
+ * TE timing as seen by the panel, for userspace to pace frames against.
+ *
+ * te_rate: effective TE rate in Hz, i.e. the idle rate while auto mode idles.
+ *	    Pollable, notified when it changes.
+ * te_usec: TE pulse width in us.
+ * te2_changeable: 1 if TE2 follows the changeable TE, 0 if it's fixed.
+ */
+static ssize_t hk3_te_info_show(struct device *dev, char *buf,
+				u32 (*get)(struct exynos_panel *ctx,
+					   const struct exynos_panel_mode *pmode))
+{
+	struct exynos_panel *ctx = mipi_dsi_get_drvdata(to_mipi_dsi_device(dev));
+	const struct exynos_panel_mode *pmode;
+	u32 val;
+
+	if (!ctx)
+		return -ENODEV;
+
+	mutex_lock(&ctx->mode_lock);
+	pmode = ctx->current_mode;
+	if (!pmode || !is_panel_active(ctx)) {
+		mutex_unlock(&ctx->mode_lock);
+		return -EAGAIN;
+	}
+	val = get(ctx, pmode);
+	mutex_unlock(&ctx->mode_lock);
+
+	return sysfs_emit(buf, "%u\n", val);
+}
+
+static u32 hk3_get_te_rate(struct exynos_panel *ctx, const struct exynos_panel_mode *pmode)
+{
+	struct hk3_panel *spanel = to_spanel(ctx);
+
+	return ctx->panel_idle_vrefresh ?: spanel->hw_vrefresh ?: drm_mode_vrefresh(&pmode->mode);
+}
+
+static u32 hk3_get_te_usec_attr(struct exynos_panel *ctx, const struct exynos_panel_mode *pmode)
+{
+	return hk3_get_te_usec(ctx, pmode);
+}
+
+static u32 hk3_get_te2_changeable(struct exynos_panel *ctx,
+				  const struct exynos_panel_mode *pmode)
+{
+	return hk3_get_te2_option(ctx) != HK3_TE2_FIXED;
+}
+
+static ssize_t te_rate_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	return hk3_te_info_show(dev, buf, hk3_get_te_rate);
+}
+static DEVICE_ATTR_RO(te_rate);
+
+static ssize_t te_usec_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	return hk3_te_info_show(dev, buf, hk3_get_te_usec_attr);
+}
+static DEVICE_ATTR_RO(te_usec);
+
+static ssize_t te2_changeable_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	return hk3_te_info_show(dev, buf, hk3_get_te2_changeable);
+}
+static DEVICE_ATTR_RO(te2_changeable);
+
+static struct attribute *hk3_attrs[] = {
+	&dev_attr_content_cadence.attr,
+	&dev_attr_te_rate.attr,
+	&dev_attr_te_usec.attr,
+	&dev_attr_te2_changeable.attr,
+	NULL
+};
+ATTRIBUTE_GROUPS(hk3);
+
 static int hk3_panel_probe(struct mipi_dsi_device *dsi)
 {
+	const struct exynos_panel_desc *desc;
 	struct hk3_panel *spanel;
+	int ret;
 
 	spanel = devm_kzalloc(&dsi->dev, sizeof(*spanel), GFP_KERNEL);
 	if (!spanel)
@@ -2649,6 +2999,8 @@ static int hk3_panel_probe(struct mipi_dsi_device *dsi)
 
 	spanel->base.op_hz = 120;
 	spanel->hw_vrefresh = 60;
+	panel_residency_init(&spanel->residency);
+	spanel->binned_lp_hysteresis = BINNED_LP_HYSTERESIS_DEFAULT;
 	spanel->hw_acl_setting = 0;
 	spanel->hw_za_enabled = false;
 	spanel->hw_dbv = 0;
@@ -2658,7 +3010,23 @@ static int hk3_panel_probe(struct mipi_dsi_device *dsi)
 	spanel->is_pixel_off = false;
 	spanel->read_vreg = false;
 
-	return exynos_panel_common_init(dsi, &spanel->base);
+	desc = of_device_get_match_data(&dsi->dev);
+	ret = panel_dsc_validate(&dsi->dev, desc);
+	if (ret)
+		return ret;
+	ret = panel_timing_check(&dsi->dev, desc,
+				 min(MIPI_DSI_FREQ_DEFAULT, MIPI_DSI_FREQ_ALTERNATIVE),
+				 HK3_DSI_DATA_LANES);
+	if (ret)
+		return ret;
+
+	ret = exynos_panel_common_init(dsi, &spanel->base);
+	if (ret)
+		return ret;
+
+	hk3_touch_ee_register(spanel);
+
+	return 0;
 }
 
 static int hk3_panel_config(struct exynos_panel *ctx)
@@ -2680,7 +3048,7 @@ static const struct exynos_panel_funcs hk3_exynos_funcs = {
 	.set_brightness = hk3_set_brightness,
 	.set_lp_mode = hk3_set_lp_mode,
 	.set_nolp_mode = hk3_set_nolp_mode,
-	.set_binned_lp = exynos_panel_set_binned_lp,
+	.set_binned_lp = hk3_set_binned_lp,
 	.set_hbm_mode = hk3_set_hbm_mode,
 	.set_dimming_on = hk3_set_dimming_on,
 	.set_local_hbm_mode = hk3_set_local_hbm_mode,
@@ -2793,6 +3161,8 @@ static struct mipi_dsi_driver exynos_panel_driver = {
 	.driver = {
 		.name = "panel-google-hk3",
 		.of_match_table = exynos_panel_of_match,
+		.dev_groups = hk3_groups,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 module_mipi_dsi_driver(exynos_panel_driver);
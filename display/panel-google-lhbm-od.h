@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Local HBM overdrive brightness helpers shared by Google panels.
+ *
+ * Copyright (c) 2023 Google LLC
+ */
+
+#ifndef _PANEL_GOOGLE_LHBM_OD_H_
+#define _PANEL_GOOGLE_LHBM_OD_H_
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/types.h>
+
+#define LHBM_OD_MAX_GROUPS	4
+#define LHBM_OD_MAX_CHANNELS	3
+#define LHBM_OD_MAX_BRT_LEN	6
+
+/**
+ * enum lhbm_od_channel_type - how an overdrive offset applies to a channel
+ * @LHBM_OD_FINE_COARSE: 8-bit fine value, moving to the alternate coarse step on overflow
+ * @LHBM_OD_BE16: 16-bit big endian value, the offset is added to it
+ */
+enum lhbm_od_channel_type {
+	LHBM_OD_FINE_COARSE = 0,
+	LHBM_OD_BE16,
+};
+
+/**
+ * struct lhbm_od_channel - location of one color channel in the brightness parameters
+ * @type: how offsets are applied, see enum lhbm_od_channel_type
+ * @fine: index of the fine byte, or of the high byte for LHBM_OD_BE16
+ * @coarse: index of the coarse byte, unused for LHBM_OD_BE16
+ * @coarse_mask: bits of the coarse byte owned by this channel, unused for LHBM_OD_BE16
+ */
+struct lhbm_od_channel {
+	u8 type;
+	u8 fine;
+	u8 coarse;
+	u8 coarse_mask;
+};
+
+/**
+ * struct lhbm_od_offset - overdrive offsets of one channel in one group
+ * @fine_0: added to fine if it doesn't overflow, or the offset for LHBM_OD_BE16
+ * @fine_1: subtracted from fine on overflow
+ * @coarse_0: added to coarse if fine doesn't overflow
+ * @coarse_1: added to coarse on overflow
+ */
+struct lhbm_od_offset {
+	u8 fine_0;
+	u8 fine_1;
+	u8 coarse_0;
+	u8 coarse_1;
+};
+
+/**
+ * struct lhbm_od_desc - fixed overdrive description of a panel
+ * @reg: brightness register, sent as the first byte of the command
+ * @brt_len: length of the brightness parameters
+ * @channels: color channels within the brightness parameters
+ * @num_channels: number of entries in @channels
+ * @offsets: offsets per group, indexed by [group][channel]
+ * @num_groups: number of overdrive groups
+ */
+struct lhbm_od_desc {
+	u8 reg;
+	u8 brt_len;
+	const struct lhbm_od_channel *channels;
+	u8 num_channels;
+	const struct lhbm_od_offset (*offsets)[LHBM_OD_MAX_CHANNELS];
+	u8 num_groups;
+};
+
+/**
+ * struct lhbm_od - overdrive runtime state of a panel instance
+ * @desc: panel description, NULL until lhbm_od_init() succeeds
+ * @cmd: ready to send commands, one per group followed by the normal brightness
+ * @group: group of the last selected command, desc->num_groups for normal brightness
+ */
+struct lhbm_od {
+	const struct lhbm_od_desc *desc;
+	u8 cmd[LHBM_OD_MAX_GROUPS + 1][LHBM_OD_MAX_BRT_LEN + 1];
+	u8 group;
+};
+
+static inline void lhbm_od_apply(const struct lhbm_od_channel *ch,
+				 const struct lhbm_od_offset *off, u8 *brt)
+{
+	if (ch->type == LHBM_OD_BE16) {
+		const u16 val = ((brt[ch->fine] << 8) | brt[ch->fine + 1]) + off->fine_0;
+
+		brt[ch->fine] = val >> 8;
+		brt[ch->fine + 1] = val & 0xFF;
+	} else {
+		const u8 fine = brt[ch->fine];
+		u8 coarse;
+
+		if ((int)fine + off->fine_0 <= 0xFF) {
+			coarse = brt[ch->coarse] + off->coarse_0;
+			brt[ch->fine] = fine + off->fine_0;
+		} else {
+			coarse = brt[ch->coarse] + off->coarse_1;
+			brt[ch->fine] = fine - off->fine_1;
+		}
+		brt[ch->coarse] = (brt[ch->coarse] & ~ch->coarse_mask) | (coarse & ch->coarse_mask);
+	}
+}
+
+/**
+ * lhbm_od_init - compute the commands of all groups from the normal brightness
+ * @od: runtime state
+ * @desc: panel description
+ * @brt_normal: normal brightness parameters read from the panel, @desc->brt_len long
+ *
+ * Return: 0 on success, -EINVAL if @desc doesn't fit in struct lhbm_od.
+ */
+static inline int lhbm_od_init(struct lhbm_od *od, const struct lhbm_od_desc *desc,
+			       const u8 *brt_normal)
+{
+	int grp, ch;
+
+	if (desc->num_groups > LHBM_OD_MAX_GROUPS || desc->brt_len > LHBM_OD_MAX_BRT_LEN ||
+	    desc->num_channels > LHBM_OD_MAX_CHANNELS)
+		return -EINVAL;
+
+	for (grp = 0; grp <= desc->num_groups; grp++) {
+		u8 *cmd = od->cmd[grp];
+
+		cmd[0] = desc->reg;
+		memcpy(cmd + 1, brt_normal, desc->brt_len);
+		if (grp == desc->num_groups)
+			break;
+
+		/* a channel only updates its own bits of a shared coarse byte */
+		for (ch = 0; ch < desc->num_channels; ch++)
+			lhbm_od_apply(&desc->channels[ch], &desc->offsets[grp][ch], cmd + 1);
+	}
+	od->desc = desc;
+	od->group = desc->num_groups;
+
+	return 0;
+}
+
+/**
+ * lhbm_od_select - pick the command for an overdrive group
+ * @od: runtime state
+ * @group: overdrive group, any value out of range selects the normal brightness
+ *
+ * Return: command to send, lhbm_od_cmd_len() bytes long, or NULL if @od isn't initialized.
+ */
+static inline const u8 *lhbm_od_select(struct lhbm_od *od, unsigned int group)
+{
+	if (!od->desc)
+		return NULL;
+
+	od->group = min_t(unsigned int, group, od->desc->num_groups);
+
+	return od->cmd[od->group];
+}
+
+static inline size_t lhbm_od_cmd_len(const struct lhbm_od *od)
+{
+	return od->desc ? od->desc->brt_len + 1 : 0;
+}
+
+/* whether the last selected command is an overdrive one */
+static inline bool lhbm_od_is_overdrived(const struct lhbm_od *od)
+{
+	return od->desc && od->group < od->desc->num_groups;
+}
+
+#endif /* _PANEL_GOOGLE_LHBM_OD_H_ */
@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Display power state residency shared by Google panels.
+ *
+ * Copyright (c) 2023 Google LLC
+ */
+
+#include <linux/debugfs.h>
+#include <linux/module.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+
+#include "panel-google-residency.h"
+
+void panel_residency_init(struct panel_residency *res)
+{
+	memset(res, 0, sizeof(*res));
+	seqlock_init(&res->lock);
+	res->since = res->reset_ts = ktime_get();
+}
+
+/* account the time elapsed in the current state up to @now, lock held for writing */
+static void panel_residency_account(struct panel_residency *res, ktime_t now)
+{
+	const u64 delta = ktime_to_ns(ktime_sub(now, res->since));
+	u32 i;
+
+	res->since = now;
+	/* time with the panel off isn't interesting */
+	if (!res->cur.vrefresh)
+		return;
+
+	for (i = 0; i < res->num_states; i++) {
+		if (!memcmp(&res->states[i], &res->cur, sizeof(res->cur))) {
+			res->time_ns[i] += delta;
+			return;
+		}
+	}
+
+	if (res->num_states < PANEL_RESIDENCY_MAX_STATES) {
+		res->states[res->num_states] = res->cur;
+		res->time_ns[res->num_states++] = delta;
+	} else {
+		res->other_ns += delta;
+	}
+}
+
+/**
+ * panel_residency_update - enter a new state
+ * @res: residency of the panel
+ * @state: new state
+ */
+void panel_residency_update(struct panel_residency *res,
+			    const struct panel_residency_state *state)
+{
+	if (!memcmp(&res->cur, state, sizeof(*state)))
+		return;
+
+	write_seqlock(&res->lock);
+	panel_residency_account(res, ktime_get());
+	res->cur = *state;
+	write_sequnlock(&res->lock);
+}
+
+/**
+ * panel_residency_sample - enter the state the panel is currently in
+ * @ctx: panel
+ * @res: residency of the panel
+ * @vrefresh: refresh rate applied in the panel, 0 while the panel is off
+ *
+ * The remaining fields of the state are taken from @ctx.
+ */
+void panel_residency_sample(struct exynos_panel *ctx, struct panel_residency *res, u32 vrefresh)
+{
+	const struct exynos_panel_mode *pmode = ctx->current_mode;
+	const struct exynos_panel_funcs *funcs = ctx->desc->exynos_panel_func;
+	const u32 max_brightness = ctx->desc->max_brightness;
+	struct panel_residency_state state = {
+		.vrefresh = vrefresh,
+	};
+
+	if (vrefresh) {
+		state.idle_vrefresh = ctx->panel_idle_vrefresh;
+		/* op_hz is only meaningful on panels that can switch it */
+		state.hs = funcs && funcs->set_op_hz && ctx->op_hz != 60;
+		state.hbm = ctx->hbm_mode;
+		if (pmode && pmode->exynos_mode.is_lp_mode)
+			state.lp = ctx->current_binned_lp ?
+				ctx->current_binned_lp - ctx->desc->binned_lp + 1 : 1;
+		if (max_brightness)
+			state.band = min_t(u32, exynos_panel_get_brightness(ctx) *
+					   PANEL_RESIDENCY_NUM_BANDS / (max_brightness + 1),
+					   PANEL_RESIDENCY_NUM_BANDS - 1);
+	}
+
+	panel_residency_update(res, &state);
+}
+
+#ifdef CONFIG_DEBUG_FS
+static int panel_residency_show(struct seq_file *m, void *data)
+{
+	struct panel_residency *res = m->private;
+	struct panel_residency *snap;
+	unsigned int seq;
+	u32 i;
+
+	snap = kmalloc(sizeof(*snap), GFP_KERNEL);
+	if (!snap)
+		return -ENOMEM;
+
+	do {
+		seq = read_seqbegin(&res->lock);
+		memcpy(snap, res, sizeof(*snap));
+	} while (read_seqretry(&res->lock, seq));
+	/* include the time spent in the current state so far */
+	panel_residency_account(snap, ktime_get());
+
+	seq_printf(m, "since_ms: %lld\n", ktime_to_ms(snap->reset_ts));
+	seq_puts(m, "vrefresh idle_vrefresh hs hbm lp band time_ms\n");
+	for (i = 0; i < snap->num_states; i++) {
+		const struct panel_residency_state *s = &snap->states[i];
+
+		seq_printf(m, "%u %u %u %u %u %u %llu\n", s->vrefresh, s->idle_vrefresh, s->hs,
+			   s->hbm, s->lp, s->band, div_u64(snap->time_ns[i], NSEC_PER_MSEC));
+	}
+	if (snap->other_ns)
+		seq_printf(m, "other %llu\n", div_u64(snap->other_ns, NSEC_PER_MSEC));
+
+	kfree(snap);
+
+	return 0;
+}
+
+static int panel_residency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, panel_residency_show, inode->i_private);
+}
+
+/* any write resets the counters */
+static ssize_t panel_residency_write(struct file *file, const char __user *buf, size_t count,
+				     loff_t *ppos)
+{
+	struct panel_residency *res = ((struct seq_file *)file->private_data)->private;
+
+	write_seqlock(&res->lock);
+	res->num_states = 0;
+	res->other_ns = 0;
+	res->since = res->reset_ts = ktime_get();
+	write_sequnlock(&res->lock);
+
+	return count;
+}
+
+static const struct file_operations panel_residency_fops = {
+	.owner = THIS_MODULE,
+	.open = panel_residency_open,
+	.read = seq_read,
+	.write = panel_residency_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void panel_residency_debugfs_init(struct panel_residency *res, struct dentry *parent)
+{
+	debugfs_create_file("residency", 0600, parent, res, &panel_residency_fops);
+}
+#endif /* CONFIG_DEBUG_FS */
@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Display power state residency shared by Google panels.
+ *
+ * Time is accounted to the combination of refresh rate, idle rate, NS/HS,
+ * HBM/IRC, LP bin and brightness band the panel is in. Drivers call
+ * panel_residency_update() wherever any of these may change, updates which
+ * don't change the state only cost a comparison. The counters are dumped and
+ * reset through the "residency" debugfs node of the panel.
+ *
+ * panel-google-residency.o is linked into each panel module.
+ *
+ * Copyright (c) 2023 Google LLC
+ */
+
+#ifndef _PANEL_GOOGLE_RESIDENCY_H_
+#define _PANEL_GOOGLE_RESIDENCY_H_
+
+#include <linux/ktime.h>
+#include <linux/seqlock.h>
+#include <linux/types.h>
+
+#include "panel/panel-samsung-drv.h"
+
+struct dentry;
+
+#define PANEL_RESIDENCY_MAX_STATES	64
+#define PANEL_RESIDENCY_NUM_BANDS	8
+
+/**
+ * struct panel_residency_state - power relevant state of a panel
+ * @vrefresh: refresh rate applied in the panel, 0 while the panel is off
+ * @idle_vrefresh: idle rate while idle, 0 otherwise
+ * @hs: 1 for high speed (op_hz 120), 0 for normal speed
+ * @hbm: enum exynos_hbm_mode
+ * @lp: 0 outside of LP mode, otherwise index of the binned LP + 1
+ * @band: brightness band, brightness * PANEL_RESIDENCY_NUM_BANDS / (max + 1)
+ */
+struct panel_residency_state {
+	u16 vrefresh;
+	u16 idle_vrefresh;
+	u8 hs;
+	u8 hbm;
+	u8 lp;
+	u8 band;
+};
+
+/**
+ * struct panel_residency - time in state accounting of a panel
+ * @lock: taken for writing by updates, readers retry instead of blocking them
+ * @cur: current state
+ * @since: time @cur was entered
+ * @states: states seen since the last reset
+ * @time_ns: time spent in each of @states
+ * @num_states: number of entries in @states
+ * @other_ns: time spent in states which didn't fit in @states
+ * @reset_ts: time of the last reset
+ */
+struct panel_residency {
+	seqlock_t lock;
+	struct panel_residency_state cur;
+	ktime_t since;
+	struct panel_residency_state states[PANEL_RESIDENCY_MAX_STATES];
+	u64 time_ns[PANEL_RESIDENCY_MAX_STATES];
+	u32 num_states;
+	u64 other_ns;
+	ktime_t reset_ts;
+};
+
+void panel_residency_init(struct panel_residency *res);
+void panel_residency_update(struct panel_residency *res,
+			    const struct panel_residency_state *state);
+void panel_residency_sample(struct exynos_panel *ctx, struct panel_residency *res, u32 vrefresh);
+
+#ifdef CONFIG_DEBUG_FS
+void panel_residency_debugfs_init(struct panel_residency *res, struct dentry *parent);
+#else
+static inline void panel_residency_debugfs_init(struct panel_residency *res,
+						struct dentry *parent)
+{
+}
+#endif /* CONFIG_DEBUG_FS */
+
+#endif /* _PANEL_GOOGLE_RESIDENCY_H_ */
@@ -12,6 +12,12 @@
 
 #include "include/trace/dpu_trace.h"
 #include "panel/panel-samsung-drv.h"
+#include "panel-google-binned-lp.h"
+#include "panel-google-calib.h"
+#include "panel-google-dsc.h"
+#include "panel-google-lhbm-od.h"
+#include "panel-google-residency.h"
+#include "panel-google-timing.h"
 
 static const struct drm_dsc_config pps_config = {
 	.line_buf_depth = 9,
@@ -90,6 +96,7 @@ static const struct drm_dsc_config pps_config = {
 
 #define MIPI_DSI_FREQ_DEFAULT 756
 #define MIPI_DSI_FREQ_ALTERNATIVE 776
+#define SHORELINE_DSI_DATA_LANES 4
 
 #define WIDTH_MM 64
 #define HEIGHT_MM 143
@@ -233,13 +240,55 @@ enum shoreline_lhbm_brt_overdrive_group {
 	LHBM_OVERDRIVE_GRP_MAX
 };
 
+static const struct lhbm_od_channel shoreline_lhbm_od_channels[] = {
+	{ LHBM_OD_FINE_COARSE, LHBM_R_FINE, LHBM_R_COARSE, 0xFF },
+	{ LHBM_OD_FINE_COARSE, LHBM_G_FINE, LHBM_GB_COARSE, 0xF0 },
+	{ LHBM_OD_FINE_COARSE, LHBM_B_FINE, LHBM_GB_COARSE, 0x0F },
+};
+
+/* fine_0, fine_1, coarse_0, coarse_1 for R, G and B */
+static const struct lhbm_od_offset
+shoreline_lhbm_od_offsets[LHBM_OVERDRIVE_GRP_MAX][LHBM_OD_MAX_CHANNELS] = {
+	/* 0 nit */
+	[LHBM_OVERDRIVE_GRP_0_NIT] = {
+		{ 0x83, 0x5A, 0x00, 0x01 },
+		{ 0x90, 0x60, 0x00, 0x10 },
+		{ 0xB0, 0x23, 0x00, 0x01 },
+	},
+	/* 0 - 6 nits */
+	[LHBM_OVERDRIVE_GRP_6_NIT] = {
+		{ 0x53, 0x8A, 0x00, 0x01 },
+		{ 0x60, 0x90, 0x00, 0x10 },
+		{ 0x80, 0x53, 0x00, 0x01 },
+	},
+	/* 6 - 50 nits */
+	[LHBM_OVERDRIVE_GRP_50_NIT] = {
+		{ 0x36, 0x9E, 0x00, 0x01 },
+		{ 0x49, 0xA4, 0x00, 0x10 },
+		{ 0x66, 0x67, 0x00, 0x01 },
+	},
+	/* 50 - 300 nits */
+	[LHBM_OVERDRIVE_GRP_300_NIT] = {
+		{ 0x16, 0xBE, 0x00, 0x01 },
+		{ 0x29, 0xC4, 0x00, 0x10 },
+		{ 0x46, 0x87, 0x00, 0x01 },
+	},
+};
+
+static const struct lhbm_od_desc shoreline_lhbm_od_desc = {
+	.reg = 0x66, /* lhbm_brightness_reg */
+	.brt_len = LHBM_BRT_LEN,
+	.channels = shoreline_lhbm_od_channels,
+	.num_channels = ARRAY_SIZE(shoreline_lhbm_od_channels),
+	.offsets = shoreline_lhbm_od_offsets,
+	.num_groups = LHBM_OVERDRIVE_GRP_MAX,
+};
+
 struct shoreline_lhbm_ctl {
 	/** @brt_normal: normal LHBM brightness parameters */
 	u8 brt_normal[LHBM_BRT_LEN];
-	/** @brt_overdrive: overdrive LHBM brightness parameters */
-	u8 brt_overdrive[LHBM_OVERDRIVE_GRP_MAX][LHBM_BRT_LEN];
-	/** @overdrived: whether LHBM is overdrived */
-	bool overdrived;
+	/** @od: overdrive state and precomputed brightness commands */
+	struct lhbm_od od;
 	/** @hist_roi_configured: whether LHBM histogram configuration is done */
 	bool hist_roi_configured;
 };
@@ -248,7 +297,9 @@ struct shoreline_lhbm_ctl {
  * struct shoreline_panel - panel specific runtime info
  *
  * This struct maintains shoreline panel specific runtime info, any fixed details about panel
- * should most likely go into struct exynos_panel_desc
+ * should most likely go into struct exynos_panel_desc. The variables with the prefix hw_ keep
+ * track of what was actually committed to hardware, and should be modified after sending
+ * cmds to panel, i.e. updating hw state.
  */
 struct shoreline_panel {
 	/** @base: base panel struct */
@@ -261,10 +312,22 @@ struct shoreline_panel {
 
 	/** @vreg_cmd: vreg data */
 	u8 vreg_cmd[VREG_SET_CMD_SIZE];
+
+	/** @hw_te2: TE2 timing currently programmed in the panel */
+	struct exynos_panel_te2_timing hw_te2;
+	/** @hw_te2_vrefresh: refresh rate @hw_te2 was programmed for, 0 if unknown */
+	u32 hw_te2_vrefresh;
+	/** @hw_vrefresh: vrefresh rate effective in panel, 0 if unknown */
+	u32 hw_vrefresh;
+	/** @residency: time spent in each power state */
+	struct panel_residency residency;
+	/** @binned_lp_hysteresis: brightness levels to move past a bin threshold in AOD */
+	u16 binned_lp_hysteresis;
 };
 
 #define to_spanel(ctx) container_of(ctx, struct shoreline_panel, base)
 
+/* the caller is expected to have test key F0 unlocked or queued */
 static void shoreline_lhbm_gamma_read(struct exynos_panel *ctx)
 {
 	struct mipi_dsi_device *dsi = to_mipi_dsi_device(ctx->dev);
@@ -272,9 +335,14 @@ static void shoreline_lhbm_gamma_read(struct exynos_panel *ctx)
 	int ret;
 	u8 *lhbm_gamma = spanel->lhbm_gamma;
 
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_on_f0);
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x00, 0x22, 0xD8); /* global para */
-	ret = mipi_dsi_dcs_read(dsi, 0xD8, lhbm_gamma + 1, LHBM_GAMMA_CMD_SIZE - 1);
+	ret = panel_calib_get(ctx->dev, "google,lhbm-gamma", lhbm_gamma + 1,
+			      LHBM_GAMMA_CMD_SIZE - 1);
+	if (!ret) {
+		ret = LHBM_GAMMA_CMD_SIZE - 1;
+	} else {
+		EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, 0xB0, 0x00, 0x22, 0xD8); /* global para */
+		ret = mipi_dsi_dcs_read(dsi, 0xD8, lhbm_gamma + 1, LHBM_GAMMA_CMD_SIZE - 1);
+	}
 	if (ret == (LHBM_GAMMA_CMD_SIZE - 1)) {
 		/* fill in gamma write command 0x66 in offset 0 */
 		lhbm_gamma[0] = 0x66;
@@ -282,11 +350,10 @@ static void shoreline_lhbm_gamma_read(struct exynos_panel *ctx)
 	} else {
 		dev_err(ctx->dev, "fail to read LHBM gamma\n");
 	}
-
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_off_f0);
 }
 
-static void shoreline_lhbm_gamma_write(struct exynos_panel *ctx)
+/* queue the LHBM gamma write, the caller takes care of test key F0 and flush */
+static void shoreline_lhbm_gamma_buf_add(struct exynos_panel *ctx)
 {
 	struct shoreline_panel *spanel = to_spanel(ctx);
 
@@ -296,10 +363,8 @@ static void shoreline_lhbm_gamma_write(struct exynos_panel *ctx)
 	}
 
 	dev_dbg(ctx->dev, "%s\n", __func__);
-	EXYNOS_DCS_BUF_ADD_SET(ctx, test_key_on_f0);
 	EXYNOS_DCS_BUF_ADD(ctx, 0xB0, 0x03, 0xD7, 0x66); /* global para */
 	EXYNOS_DCS_BUF_ADD_SET(ctx, spanel->lhbm_gamma); /* write gamma */
-	EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, test_key_off_f0);
 }
 
 static void shoreline_wait_for_vsync_done(struct exynos_panel *ctx)
@@ -323,9 +388,14 @@ static void shoreline_vreg_read(struct exynos_panel *ctx)
 	u8 *vreg_cmd = spanel->vreg_cmd;
 	int ret;
 
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_on_f0);
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x00, 0x3A , 0xF4); /* global para */
-	ret = mipi_dsi_dcs_read(dsi, 0xF4, vreg_cmd + 1, VREG_SET_CMD_SIZE - 1);
+	ret = panel_calib_get(ctx->dev, "google,vreg", vreg_cmd + 1, VREG_SET_CMD_SIZE - 1);
+	if (!ret) {
+		ret = VREG_SET_CMD_SIZE - 1;
+	} else {
+		/* test key F0 is unlocked by the caller */
+		EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, 0xB0, 0x00, 0x3A, 0xF4); /* global para */
+		ret = mipi_dsi_dcs_read(dsi, 0xF4, vreg_cmd + 1, VREG_SET_CMD_SIZE - 1);
+	}
 	if (ret == (VREG_SET_CMD_SIZE - 1)) {
 		/* fill in vreg command 0xF4 in offset 0 */
 		vreg_cmd[0] = 0xF4;
@@ -333,8 +403,6 @@ static void shoreline_vreg_read(struct exynos_panel *ctx)
 	} else {
 		dev_err(ctx->dev, "fail to read vreg setting\n");
 	}
-
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_off_f0);
 };
 
 static void shoreline_display_on(struct exynos_panel *ctx)
@@ -384,20 +452,66 @@ static void shoreline_display_off(struct exynos_panel *ctx)
 	EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, 0x00);
 };
 
-static void shoreline_update_te(struct exynos_panel *ctx, const unsigned int vrefresh)
+static void shoreline_te_width_buf_add(struct exynos_panel *ctx, const unsigned int vrefresh)
 {
 	static const u8 te_setting[2][5] = {
 		{0xB9, 0x09, 0x74, 0x00, 0x0C}, /* HS 60Hz */
 		{0xB9, 0x00, 0x44, 0x00, 0x0C}, /* HS 120Hz */
 	};
 
-	EXYNOS_DCS_BUF_ADD_SET(ctx, test_key_on_f0);
-	EXYNOS_DCS_BUF_ADD(ctx, 0xB9, (vrefresh == 60) ? 0x11 : 0x31); /* TE SELECT */
 	EXYNOS_DCS_BUF_ADD(ctx, 0xB0, 0x00, 0x10, 0xB9); /* global para */
 	EXYNOS_DCS_BUF_ADD_SET(ctx, te_setting[(vrefresh == 60) ? 0 : 1]); /* TE Width */
+}
+
+static void shoreline_update_te(struct exynos_panel *ctx, const unsigned int vrefresh)
+{
+	EXYNOS_DCS_BUF_ADD_SET(ctx, test_key_on_f0);
+	EXYNOS_DCS_BUF_ADD(ctx, 0xB9, (vrefresh == 60) ? 0x11 : 0x31); /* TE SELECT */
+	shoreline_te_width_buf_add(ctx, vrefresh);
 	EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, test_key_off_f0);
 }
 
+static void shoreline_get_te2_timing(struct exynos_panel *ctx,
+				     const struct exynos_panel_mode *pmode,
+				     struct exynos_panel_te2_timing *timing)
+{
+	struct exynos_panel_te2_timing cur;
+
+	*timing = pmode->te2_timing;
+
+	/* user configured edges only apply to the mode that is currently set */
+	if (pmode == ctx->current_mode && !exynos_panel_get_current_mode_te2(ctx, &cur))
+		*timing = cur;
+}
+
+static bool shoreline_te2_is_programmed(struct exynos_panel *ctx, const unsigned int vrefresh,
+					const struct exynos_panel_te2_timing *timing)
+{
+	const struct shoreline_panel *spanel = to_spanel(ctx);
+
+	return spanel->hw_te2_vrefresh == vrefresh &&
+	       spanel->hw_te2.rising_edge == timing->rising_edge &&
+	       spanel->hw_te2.falling_edge == timing->falling_edge;
+}
+
+static void shoreline_te2_width_buf_add(struct exynos_panel *ctx, const unsigned int vrefresh,
+					const struct exynos_panel_te2_timing *timing)
+{
+	struct shoreline_panel *spanel = to_spanel(ctx);
+	const u32 rising = timing->rising_edge;
+	const u32 falling = timing->falling_edge;
+
+	EXYNOS_DCS_BUF_ADD(ctx, 0xB0, 0x00, (vrefresh == 60) ? 0x1A : 0x26, 0xB9); /* global para */
+	EXYNOS_DCS_BUF_ADD(ctx, 0xB9, (rising >> 8) & 0xFF, rising & 0xFF,
+			     (falling >> 8) & 0xFF, falling & 0xFF); /* TE2 Width */
+
+	spanel->hw_te2 = *timing;
+	spanel->hw_te2_vrefresh = vrefresh;
+
+	dev_dbg(ctx->dev, "TE2 updated: rising=0x%X falling=0x%X for %uHz\n",
+		rising, falling, vrefresh);
+}
+
 /**
  * shoreline_update_te2 - update the TE2 for shoreline panels
  * @ctx: panel struct
@@ -415,57 +529,100 @@ static void shoreline_update_te(struct exynos_panel *ctx, const unsigned int vre
  *
  * TE2 falling at 60Hz (with GPO DC):
  * Refer to current vsync falling and shift right, min 0x1, max 0x96F
+ *
+ * TE2 is also programmed as part of shoreline_change_frequency(), so this only
+ * sends commands if the timing differs from what the panel already has.
  */
 static void shoreline_update_te2(struct exynos_panel *ctx)
 {
-	const struct exynos_panel_mode *pmode = ctx->current_mode;
-	unsigned int vrefresh = drm_mode_vrefresh(&pmode->mode);
-	struct exynos_panel_te2_timing timing = {
-		.rising_edge = SHORELINE_TE2_RISING_EDGE_60HZ,
-		.falling_edge = SHORELINE_TE2_FALLING_EDGE_60HZ,
-	};
-	u32 rising, falling;
-	int ret;
+	const struct exynos_panel_mode *pmode;
+	struct exynos_panel_te2_timing timing;
+	unsigned int vrefresh;
 
 	if (!ctx)
 		return;
 
+	pmode = ctx->current_mode;
 	/* Not needed to update TE2 in LP mode */
-	if (ctx->current_mode->exynos_mode.is_lp_mode)
+	if (pmode->exynos_mode.is_lp_mode)
 		return;
 
-	ret = exynos_panel_get_current_mode_te2(ctx, &timing);
-	if (ret) {
-		dev_dbg(ctx->dev, "failed to get TE2 timng\n");
+	vrefresh = drm_mode_vrefresh(&pmode->mode);
+	shoreline_get_te2_timing(ctx, pmode, &timing);
+	if (shoreline_te2_is_programmed(ctx, vrefresh, &timing))
 		return;
-	}
-	rising = timing.rising_edge;
-	falling = timing.falling_edge;
-
-	dev_dbg(ctx->dev, "TE2 updated: rising=0x%X falling=0x%X for %uHz\n",
-		rising, falling, vrefresh);
 
 	EXYNOS_DCS_BUF_ADD_SET(ctx, test_key_on_f0);
 	EXYNOS_DCS_BUF_ADD(ctx, 0xB0, 0x00, 0x01, 0xB9); /* global para */
 	EXYNOS_DCS_BUF_ADD(ctx, 0xB9, (vrefresh == 60) ? 0x04 : 0x31); /* TE2 SELECT */
-	EXYNOS_DCS_BUF_ADD(ctx, 0xB0, 0x00, (vrefresh == 60) ? 0x1A : 0x26, 0xB9); /* global para */
-	EXYNOS_DCS_BUF_ADD(ctx, 0xB9, (rising >> 8) & 0xFF, rising & 0xFF,
-			     (falling >> 8) & 0xFF, falling & 0xFF); /* TE2 Width */
+	shoreline_te2_width_buf_add(ctx, vrefresh, &timing);
 	EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, test_key_off_f0);
 }
 
+static void shoreline_update_residency(struct exynos_panel *ctx)
+{
+	struct shoreline_panel *spanel = to_spanel(ctx);
+
+	panel_residency_sample(ctx, &spanel->residency,
+			       is_panel_active(ctx) ? spanel->hw_vrefresh : 0);
+}
+
+/**
+ * shoreline_change_frequency - switch refresh rate in normal mode
+ * @ctx: panel struct
+ * @pmode: target panel mode
+ * @lock: whether to send the test keys and flush, otherwise the caller does
+ *
+ * Frequency, TE and TE2 settings are queued together so that a single
+ * freq_update latches all of them, and the whole sequence goes out in one
+ * flush. TE SELECT (B9h offset 0) and TE2 SELECT (B9h offset 1) are adjacent,
+ * so they are written with one packet. Nothing is sent if the panel already
+ * has the requested state.
+ */
 static void shoreline_change_frequency(struct exynos_panel *ctx,
-				       const unsigned int vrefresh)
+				       const struct exynos_panel_mode *pmode, bool lock)
 {
-	if (!ctx || (vrefresh != 60 && vrefresh != 120))
+	struct shoreline_panel *spanel;
+	struct exynos_panel_te2_timing te2;
+	bool te2_update;
+	u32 vrefresh;
+
+	if (!ctx || !pmode)
 		return;
 
-	EXYNOS_DCS_BUF_ADD_SET(ctx, test_key_on_f0);
-	EXYNOS_DCS_BUF_ADD(ctx, 0x60, (vrefresh == 120) ? 0x00 : 0x08, 0x00);
+	vrefresh = drm_mode_vrefresh(&pmode->mode);
+	if (vrefresh != 60 && vrefresh != 120)
+		return;
+
+	spanel = to_spanel(ctx);
+	shoreline_get_te2_timing(ctx, pmode, &te2);
+	te2_update = !shoreline_te2_is_programmed(ctx, vrefresh, &te2);
+	if (vrefresh == spanel->hw_vrefresh && !te2_update) {
+		dev_dbg(ctx->dev, "%s: no changes, skip update\n", __func__);
+		return;
+	}
+
+	DPU_ATRACE_BEGIN(__func__);
+	if (lock)
+		EXYNOS_DCS_BUF_ADD_SET(ctx, test_key_on_f0);
+	if (vrefresh != spanel->hw_vrefresh) {
+		EXYNOS_DCS_BUF_ADD(ctx, 0x60, (vrefresh == 120) ? 0x00 : 0x08, 0x00);
+		EXYNOS_DCS_BUF_ADD(ctx, 0xB9, (vrefresh == 60) ? 0x11 : 0x31,
+				     (vrefresh == 60) ? 0x04 : 0x31); /* TE and TE2 SELECT */
+		shoreline_te_width_buf_add(ctx, vrefresh);
+	} else {
+		EXYNOS_DCS_BUF_ADD(ctx, 0xB0, 0x00, 0x01, 0xB9); /* global para */
+		EXYNOS_DCS_BUF_ADD(ctx, 0xB9, (vrefresh == 60) ? 0x04 : 0x31); /* TE2 SELECT */
+	}
+	if (te2_update)
+		shoreline_te2_width_buf_add(ctx, vrefresh, &te2);
 	EXYNOS_DCS_BUF_ADD_SET(ctx, freq_update);
-	EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, test_key_off_f0);
+	if (lock)
+		EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, test_key_off_f0);
+	DPU_ATRACE_END(__func__);
 
-	shoreline_update_te(ctx, vrefresh);
+	spanel->hw_vrefresh = vrefresh;
+	shoreline_update_residency(ctx);
 
 	dev_dbg(ctx->dev, "frequency changed to %uhz\n", vrefresh);
 }
@@ -495,6 +652,11 @@ static void shoreline_update_lhbm_hist_config(struct exynos_panel *ctx)
 	}
 }
 
+static void shoreline_commit_done(struct exynos_panel *ctx)
+{
+	shoreline_update_residency(ctx);
+}
+
 static int shoreline_atomic_check(struct exynos_panel *ctx, struct drm_atomic_state *state)
 {
 	shoreline_update_lhbm_hist_config(ctx);
@@ -561,7 +723,7 @@ static void shoreline_update_ffc(struct exynos_panel *ctx, unsigned int hs_clk)
 	DPU_ATRACE_END(__func__);
 }
 
-static void shoreline_update_wrctrld(struct exynos_panel *ctx)
+static u8 shoreline_get_wrctrld(struct exynos_panel *ctx)
 {
 	u8 val = SHORELINE_WRCTRLD_BCTRL_BIT;
 
@@ -577,7 +739,13 @@ static void shoreline_update_wrctrld(struct exynos_panel *ctx)
 		ctx->dimming_on ? "on" : "off",
 		ctx->hbm.local_hbm.enabled ? "on" : "off");
 
-	EXYNOS_DCS_WRITE_SEQ(ctx, MIPI_DCS_WRITE_CONTROL_DISPLAY, val);
+	return val;
+}
+
+static void shoreline_update_wrctrld(struct exynos_panel *ctx)
+{
+	EXYNOS_DCS_BUF_ADD_AND_FLUSH(ctx, MIPI_DCS_WRITE_CONTROL_DISPLAY,
+				     shoreline_get_wrctrld(ctx));
 
 	/* TODO: need to perform gamma updates */
 }
@@ -586,10 +754,15 @@ static void shoreline_set_lp_mode(struct exynos_panel *ctx, const struct exynos_
 {
 	const u16 brightness = exynos_panel_get_brightness(ctx);
 	int vrefresh = drm_mode_vrefresh(&pmode->mode);
+	struct shoreline_panel *spanel = to_spanel(ctx);
 
 	shoreline_update_te(ctx, vrefresh);
+	/* TE2 and frequency are reprogrammed on the way out of LP mode */
+	spanel->hw_te2_vrefresh = 0;
+	spanel->hw_vrefresh = vrefresh;
 
 	exynos_panel_set_binned_lp(ctx, brightness);
+	shoreline_update_residency(ctx);
 
 	dev_info(ctx->dev, "enter %dhz LP mode\n", vrefresh);
 }
@@ -597,16 +770,17 @@ static void shoreline_set_lp_mode(struct exynos_panel *ctx, const struct exynos_
 static void shoreline_set_nolp_mode(struct exynos_panel *ctx,
 				    const struct exynos_panel_mode *pmode)
 {
-	unsigned int vrefresh = drm_mode_vrefresh(&pmode->mode);
-
 	if (!ctx->enabled)
 		return;
 
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_on_f0);
+	DPU_ATRACE_BEGIN(__func__);
+	EXYNOS_DCS_BUF_ADD_SET(ctx, test_key_on_f0);
 	/* backlight control and dimming */
-	shoreline_update_wrctrld(ctx);
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_off_f0);
-	shoreline_change_frequency(ctx, vrefresh);
+	EXYNOS_DCS_BUF_ADD(ctx, MIPI_DCS_WRITE_CONTROL_DISPLAY, shoreline_get_wrctrld(ctx));
+	/* frequency, TE and TE2 */
+	shoreline_change_frequency(ctx, pmode, false);
+	EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, test_key_off_f0);
+	DPU_ATRACE_END(__func__);
 	shoreline_wait_for_vsync_done(ctx);
 
 	dev_info(ctx->dev, "exit LP mode\n");
@@ -616,7 +790,6 @@ static int shoreline_enable(struct drm_panel *panel)
 {
 	struct exynos_panel *ctx = container_of(panel, struct exynos_panel, panel);
 	const struct exynos_panel_mode *pmode = ctx->current_mode;
-	const struct drm_display_mode *mode;
 	struct drm_dsc_picture_parameter_set pps_payload;
 	struct shoreline_panel *spanel = to_spanel(ctx);
 
@@ -624,7 +797,6 @@ static int shoreline_enable(struct drm_panel *panel)
 		dev_err(ctx->dev, "no current mode set\n");
 		return -EINVAL;
 	}
-	mode = &pmode->mode;
 
 	dev_dbg(ctx->dev, "%s\n", __func__);
 
@@ -645,11 +817,16 @@ static int shoreline_enable(struct drm_panel *panel)
 
 	exynos_panel_send_cmd_set(ctx, &shoreline_init_cmd_set);
 
-	shoreline_change_frequency(ctx, drm_mode_vrefresh(mode));
-
-	shoreline_lhbm_gamma_write(ctx);
+	/* panel state is unknown after reset, program everything */
+	spanel->hw_vrefresh = 0;
+	spanel->hw_te2_vrefresh = 0;
+	shoreline_change_frequency(ctx, pmode, true);
 
-	shoreline_update_wrctrld(ctx); /* dimming and HBM */
+	EXYNOS_DCS_BUF_ADD_SET(ctx, test_key_on_f0);
+	shoreline_lhbm_gamma_buf_add(ctx);
+	/* dimming and HBM */
+	EXYNOS_DCS_BUF_ADD(ctx, MIPI_DCS_WRITE_CONTROL_DISPLAY, shoreline_get_wrctrld(ctx));
+	EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, test_key_off_f0);
 
 	ctx->enabled = true;
 
@@ -660,6 +837,7 @@ static int shoreline_enable(struct drm_panel *panel)
 
 	spanel->lhbm_ctl.hist_roi_configured = false;
 	ctx->dsi_hs_clk = MIPI_DSI_FREQ_DEFAULT;
+	shoreline_update_residency(ctx);
 
 	return 0;
 }
@@ -667,6 +845,7 @@ static int shoreline_enable(struct drm_panel *panel)
 static int shoreline_disable(struct drm_panel *panel)
 {
 	struct exynos_panel *ctx = container_of(panel, struct exynos_panel, panel);
+	struct shoreline_panel *spanel = to_spanel(ctx);
 	int ret, vrefresh, delay_us;
 
 	dev_dbg(ctx->dev, "%s\n", __func__);
@@ -682,10 +861,29 @@ static int shoreline_disable(struct drm_panel *panel)
 	shoreline_display_off(ctx);
 	exynos_panel_msleep(20);
 	EXYNOS_DCS_WRITE_SEQ_DELAY(ctx, 100, MIPI_DCS_ENTER_SLEEP_MODE);
+	panel_residency_sample(ctx, &spanel->residency, 0);
 
 	return 0;
 }
 
+static void shoreline_set_binned_lp(struct exynos_panel *ctx, const u16 brightness)
+{
+	struct shoreline_panel *spanel = to_spanel(ctx);
+
+	/* each bin switch costs a 34ms command delay, don't flip around a threshold */
+	exynos_panel_set_binned_lp(ctx, binned_lp_hysteresis(ctx, brightness,
+							     spanel->binned_lp_hysteresis));
+}
+
+static int shoreline_set_brightness(struct exynos_panel *ctx, u16 br)
+{
+	int ret = exynos_panel_set_brightness(ctx, br);
+
+	shoreline_update_residency(ctx);
+
+	return ret;
+}
+
 static void shoreline_set_hbm_mode(struct exynos_panel *ctx,
 				enum exynos_hbm_mode mode)
 {
@@ -734,6 +932,7 @@ static void shoreline_set_hbm_mode(struct exynos_panel *ctx,
 	}
 	EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, test_key_off_f0);
 	shoreline_update_wrctrld(ctx);
+	shoreline_update_residency(ctx);
 
 	dev_info(ctx->dev, "hbm_on=%d hbm_ircoff=%d\n", IS_HBM_ON(ctx->hbm_mode),
 		 IS_HBM_ON_IRC_OFF(ctx->hbm_mode));
@@ -757,11 +956,10 @@ static void shoreline_set_local_hbm_brightness(struct exynos_panel *ctx, bool is
 {
 	struct shoreline_panel *spanel = to_spanel(ctx);
 	struct shoreline_lhbm_ctl *ctl = &spanel->lhbm_ctl;
-	const u8 *brt;
 	enum shoreline_lhbm_brt_overdrive_group group = LHBM_OVERDRIVE_GRP_MAX;
-	/* command uses one byte besiddes brightness */
-	static u8 cmd[LHBM_BRT_LEN + 1];
-	int i;
+	/* command uses one byte besides brightness */
+	u8 cmd[LHBM_BRT_LEN + 1];
+	const u8 *od_cmd;
 
 	if (!is_local_hbm_post_enabling_supported(ctx))
 		return;
@@ -797,19 +995,15 @@ static void shoreline_set_local_hbm_brightness(struct exynos_panel *ctx, bool is
 			gray, dbv, luma);
 	}
 
-	if (group < LHBM_OVERDRIVE_GRP_MAX) {
-		brt = ctl->brt_overdrive[group];
-		ctl->overdrived = true;
-	} else {
-		brt = ctl->brt_normal;
-		ctl->overdrived = false;
+	od_cmd = lhbm_od_select(&ctl->od, group);
+	if (!od_cmd) {
+		dev_err(ctx->dev, "%s: no lhbm brightness\n", __func__);
+		return;
 	}
-	cmd[0] = lhbm_brightness_reg;
-	for (i = 0; i < LHBM_BRT_LEN; i++)
-		cmd[i+1] = brt[i];
+	memcpy(cmd, od_cmd, sizeof(cmd));
 	dev_dbg(ctx->dev, "set %s brightness: [%d] %*ph\n",
-		ctl->overdrived ? "overdrive" : "normal",
-		ctl->overdrived ? group : -1, LHBM_BRT_LEN, brt);
+		lhbm_od_is_overdrived(&ctl->od) ? "overdrive" : "normal",
+		lhbm_od_is_overdrived(&ctl->od) ? group : -1, LHBM_BRT_LEN, cmd + 1);
 	EXYNOS_DCS_BUF_ADD_SET(ctx, test_key_on_f0);
 	EXYNOS_DCS_BUF_ADD_SET(ctx, lhbm_brightness_index);
 	EXYNOS_DCS_BUF_ADD_SET(ctx, cmd);
@@ -820,7 +1014,7 @@ static void shoreline_set_local_hbm_mode_post(struct exynos_panel *ctx)
 {
 	const struct shoreline_panel *spanel = to_spanel(ctx);
 
-	if (spanel->lhbm_ctl.overdrived)
+	if (lhbm_od_is_overdrived(&spanel->lhbm_ctl.od))
 		shoreline_set_local_hbm_brightness(ctx, false);
 }
 
@@ -836,7 +1030,7 @@ static void shoreline_set_local_hbm_mode(struct exynos_panel *exynos_panel,
 static void shoreline_mode_set(struct exynos_panel *ctx,
 			       const struct exynos_panel_mode *pmode)
 {
-	shoreline_change_frequency(ctx, drm_mode_vrefresh(&pmode->mode));
+	shoreline_change_frequency(ctx, pmode, true);
 }
 
 static bool shoreline_is_mode_seamless(const struct exynos_panel *ctx,
@@ -846,120 +1040,62 @@ static bool shoreline_is_mode_seamless(const struct exynos_panel *ctx,
 	return drm_mode_equal_no_clocks(&ctx->current_mode->mode, &pmode->mode);
 }
 
-static void shoreline_calc_lhbm_od_brightness(u8 n_fine, u8 n_coarse,
-	u8 *o_fine, u8 *o_coarse,
-	u8 fine_offset_0, u8 fine_offset_1,
-	u8 coarse_offset_0, u8 coarse_offset_1)
-{
-	if (n_fine <= (0xFF - fine_offset_0)) {
-		*o_coarse = n_coarse + coarse_offset_0;
-		*o_fine = n_fine + fine_offset_0;
-	} else {
-		*o_coarse = n_coarse + coarse_offset_1;
-		*o_fine = n_fine - fine_offset_1;
-	}
-}
-
 static void shoreline_lhbm_brightness_init(struct exynos_panel *ctx)
 {
 	struct mipi_dsi_device *dsi = to_mipi_dsi_device(ctx->dev);
 	struct shoreline_panel *spanel = to_spanel(ctx);
 	struct shoreline_lhbm_ctl *ctl = &spanel->lhbm_ctl;
 	int ret;
-	u8 g_coarse, b_coarse;
 	u8 *p_norm = ctl->brt_normal;
-	u8 *p_over;
-	enum shoreline_lhbm_brt_overdrive_group grp;
-
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_on_f0);
-	EXYNOS_DCS_WRITE_TABLE(ctx, lhbm_brightness_index);
-	ret = mipi_dsi_dcs_read(dsi, lhbm_brightness_reg, p_norm, LHBM_BRT_LEN);
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_off_f0);
-	if (ret != LHBM_BRT_LEN) {
-		dev_err(ctx->dev, "failed to read lhbm para ret=%d\n", ret);
-		return;
+
+	if (panel_calib_get(ctx->dev, "google,lhbm-brightness", p_norm, LHBM_BRT_LEN)) {
+		/* test key F0 is unlocked by the caller */
+		EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, lhbm_brightness_index);
+		ret = mipi_dsi_dcs_read(dsi, lhbm_brightness_reg, p_norm, LHBM_BRT_LEN);
+		if (ret != LHBM_BRT_LEN) {
+			dev_err(ctx->dev, "failed to read lhbm para ret=%d\n", ret);
+			return;
+		}
 	}
 	dev_info(ctx->dev, "lhbm normal brightness: %*ph\n", LHBM_BRT_LEN, p_norm);
 
-	/* 0 nit */
-	grp = LHBM_OVERDRIVE_GRP_0_NIT;
-	p_over = ctl->brt_overdrive[grp];
-	shoreline_calc_lhbm_od_brightness(p_norm[LHBM_R_FINE], p_norm[LHBM_R_COARSE],
-		&p_over[LHBM_R_FINE], &p_over[LHBM_R_COARSE],
-		0x83, 0x5A, 0x00, 0x01);
-	shoreline_calc_lhbm_od_brightness(p_norm[LHBM_G_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_G_FINE], &g_coarse,
-		0x90, 0x60, 0x00, 0x10);
-	shoreline_calc_lhbm_od_brightness(p_norm[LHBM_B_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_B_FINE], &b_coarse,
-		0xB0, 0x23, 0x00, 0x01);
-	p_over[LHBM_GB_COARSE] = (g_coarse & 0xF0) | (b_coarse & 0x0F);
-
-	/* 0 - 6 nits */
-	grp = LHBM_OVERDRIVE_GRP_6_NIT;
-	p_over = ctl->brt_overdrive[grp];
-	shoreline_calc_lhbm_od_brightness(p_norm[LHBM_R_FINE], p_norm[LHBM_R_COARSE],
-		&p_over[LHBM_R_FINE], &p_over[LHBM_R_COARSE],
-		0x53, 0x8A, 0x00, 0x01);
-	shoreline_calc_lhbm_od_brightness(p_norm[LHBM_G_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_G_FINE], &g_coarse,
-		0x60, 0x90, 0x00, 0x10);
-	shoreline_calc_lhbm_od_brightness(p_norm[LHBM_B_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_B_FINE], &b_coarse,
-		0x80, 0x53, 0x00, 0x01);
-	p_over[LHBM_GB_COARSE] = (g_coarse & 0xF0) | (b_coarse & 0x0F);
-
-	/* 6 - 50 nits */
-	grp = LHBM_OVERDRIVE_GRP_50_NIT;
-	p_over = ctl->brt_overdrive[grp];
-	shoreline_calc_lhbm_od_brightness(p_norm[LHBM_R_FINE], p_norm[LHBM_R_COARSE],
-		&p_over[LHBM_R_FINE], &p_over[LHBM_R_COARSE],
-		0x36, 0x9E, 0x00, 0x01);
-	shoreline_calc_lhbm_od_brightness(p_norm[LHBM_G_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_G_FINE], &g_coarse,
-		0x49, 0xA4, 0x00, 0x10);
-	shoreline_calc_lhbm_od_brightness(p_norm[LHBM_B_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_B_FINE], &b_coarse,
-		0x66, 0x67, 0x00, 0x01);
-	p_over[LHBM_GB_COARSE] = (g_coarse & 0xF0) | (b_coarse & 0x0F);
-
-	/* 50 - 300 nits */
-	grp = LHBM_OVERDRIVE_GRP_300_NIT;
-	p_over = ctl->brt_overdrive[grp];
-	shoreline_calc_lhbm_od_brightness(p_norm[LHBM_R_FINE], p_norm[LHBM_R_COARSE],
-		&p_over[LHBM_R_FINE], &p_over[LHBM_R_COARSE],
-		0x16, 0xBE, 0x00, 0x01);
-	shoreline_calc_lhbm_od_brightness(p_norm[LHBM_G_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_G_FINE], &g_coarse,
-		0x29, 0xC4, 0x00, 0x10);
-	shoreline_calc_lhbm_od_brightness(p_norm[LHBM_B_FINE], p_norm[LHBM_GB_COARSE],
-		&p_over[LHBM_B_FINE], &b_coarse,
-		0x46, 0x87, 0x00, 0x01);
-	p_over[LHBM_GB_COARSE] = (g_coarse & 0xF0) | (b_coarse & 0x0F);
+	ret = lhbm_od_init(&ctl->od, &shoreline_lhbm_od_desc, p_norm);
+	if (ret) {
+		dev_err(ctx->dev, "failed to init lhbm overdrive ret=%d\n", ret);
+		return;
+	}
 
 	print_hex_dump_debug("shoreline-od-brightness: ", DUMP_PREFIX_NONE,
 		16, 1,
-		ctl->brt_overdrive, sizeof(ctl->brt_overdrive), false);
+		ctl->od.cmd, sizeof(ctl->od.cmd[0]) * LHBM_OVERDRIVE_GRP_MAX, false);
 }
 
 static void shoreline_panel_init(struct exynos_panel *ctx)
 {
 	struct dentry *csroot = ctx->debugfs_cmdset_entry;
+	struct shoreline_panel *spanel = to_spanel(ctx);
 
 	exynos_panel_debugfs_create_cmdset(ctx, csroot,
 					   &shoreline_init_cmd_set, "init");
+	panel_residency_debugfs_init(&spanel->residency, ctx->debugfs_entry);
+	debugfs_create_u16("binned_lp_hysteresis", 0644, ctx->debugfs_entry,
+			   &spanel->binned_lp_hysteresis);
+
+	/*
+	 * All reads share one test key session. Each read only needs its global para
+	 * flushed ahead of it, and the writes are sent together at the end.
+	 */
+	EXYNOS_DCS_BUF_ADD_SET(ctx, test_key_on_f0);
 	shoreline_lhbm_gamma_read(ctx);
-	shoreline_lhbm_gamma_write(ctx);
-
 	shoreline_vreg_read(ctx);
-
 	/* LHBM overdrive init */
 	shoreline_lhbm_brightness_init(ctx);
+
+	shoreline_lhbm_gamma_buf_add(ctx);
 	/* LHBM Location */
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_on_f0);
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x00, 0x09, 0x6D);
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0x6D, 0xC6, 0xE3, 0x65);
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_off_f0);
+	EXYNOS_DCS_BUF_ADD(ctx, 0xB0, 0x00, 0x09, 0x6D);
+	EXYNOS_DCS_BUF_ADD(ctx, 0x6D, 0xC6, 0xE3, 0x65);
+	EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, test_key_off_f0);
 }
 
 static int shoreline_read_id(struct exynos_panel *ctx)
@@ -979,13 +1115,27 @@ static void shoreline_get_panel_rev(struct exynos_panel *ctx, u32 id)
 
 static int shoreline_panel_probe(struct mipi_dsi_device *dsi)
 {
+	const struct exynos_panel_desc *desc;
 	struct shoreline_panel *spanel;
+	int ret;
 
 	spanel = devm_kzalloc(&dsi->dev, sizeof(*spanel), GFP_KERNEL);
 	if (!spanel)
 		return -ENOMEM;
 
 	spanel->base.op_hz = 120;
+	panel_residency_init(&spanel->residency);
+	spanel->binned_lp_hysteresis = BINNED_LP_HYSTERESIS_DEFAULT;
+
+	desc = of_device_get_match_data(&dsi->dev);
+	ret = panel_dsc_validate(&dsi->dev, desc);
+	if (ret)
+		return ret;
+	ret = panel_timing_check(&dsi->dev, desc,
+				 min(MIPI_DSI_FREQ_DEFAULT, MIPI_DSI_FREQ_ALTERNATIVE),
+				 SHORELINE_DSI_DATA_LANES);
+	if (ret)
+		return ret;
 
 	return exynos_panel_common_init(dsi, &spanel->base);
 }
@@ -1107,10 +1257,10 @@ static const struct drm_panel_funcs shoreline_drm_funcs = {
 static int shoreline_panel_config(struct exynos_panel *ctx);
 
 static const struct exynos_panel_funcs shoreline_exynos_funcs = {
-	.set_brightness = exynos_panel_set_brightness,
+	.set_brightness = shoreline_set_brightness,
 	.set_lp_mode = shoreline_set_lp_mode,
 	.set_nolp_mode = shoreline_set_nolp_mode,
-	.set_binned_lp = exynos_panel_set_binned_lp,
+	.set_binned_lp = shoreline_set_binned_lp,
 	.set_hbm_mode = shoreline_set_hbm_mode,
 	.set_dimming_on = shoreline_set_dimming_on,
 	.set_local_hbm_mode = shoreline_set_local_hbm_mode,
@@ -1125,6 +1275,7 @@ static const struct exynos_panel_funcs shoreline_exynos_funcs = {
 	.update_te2 = shoreline_update_te2,
 	.read_id = shoreline_read_id,
 	.atomic_check = shoreline_atomic_check,
+	.commit_done = shoreline_commit_done,
 	.pre_update_ffc = shoreline_pre_update_ffc,
 	.update_ffc = shoreline_update_ffc,
 };
@@ -1234,7 +1385,7 @@ static const struct exynos_brightness_configuration shoreline_btr_configs[] = {
 	},
 };
 
-static struct exynos_panel_desc google_shoreline = {
+static const struct exynos_panel_desc google_shoreline = {
 	.data_lane_cnt = 4,
 	/* supported HDR format bitmask : 1(DOLBY_VISION), 2(HDR10), 3(HLG) */
 	.hdr_formats = BIT(2) | BIT(3),
@@ -1268,9 +1419,16 @@ static struct exynos_panel_desc google_shoreline = {
 
 static int shoreline_panel_config(struct exynos_panel *ctx)
 {
+	struct exynos_panel_desc *desc;
+
 	exynos_panel_model_init(ctx, PROJECT, 0);
 
-	return exynos_panel_init_brightness(&google_shoreline,
+	desc = devm_kmemdup(ctx->dev, ctx->desc, sizeof(*desc), GFP_KERNEL);
+	if (!desc)
+		return -ENOMEM;
+	ctx->desc = desc;
+
+	return exynos_panel_init_brightness(desc,
 						shoreline_btr_configs,
 						ARRAY_SIZE(shoreline_btr_configs),
 						ctx->panel_rev);
@@ -1288,6 +1446,7 @@ static struct mipi_dsi_driver exynos_panel_driver = {
 	.driver = {
 		.name = "panel-google-shoreline",
 		.of_match_table = exynos_panel_of_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 module_mipi_dsi_driver(exynos_panel_driver);
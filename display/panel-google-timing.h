@@ -0,0 +1,188 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Display timing and link budget checks shared by Google panels.
+ *
+ * Mode tables are hand written: pixel clock, porches, TE width, vblank and DSC
+ * parameters. In command mode a frame has to be sent over DSI between two TE
+ * pulses, and the link clock of each mode comes from the dsim-modes of the
+ * device tree, so lowering a clock to save power is only safe if every mode
+ * using it still fits. With CONFIG_DRM_PANEL_GOOGLE_MODE_CHECKS panels check
+ * their modes at probe time and fail it on a bad table. Production builds
+ * compile the checks out.
+ *
+ * Copyright (c) 2023 Google LLC
+ */
+
+#ifndef _PANEL_GOOGLE_TIMING_H_
+#define _PANEL_GOOGLE_TIMING_H_
+
+#include <drm/drm_dsc.h>
+#include <linux/device.h>
+#include <linux/errno.h>
+#include <linux/kernel.h>
+#include <linux/math64.h>
+#include <linux/string.h>
+#include <linux/time64.h>
+
+#include "panel/panel-samsung-drv.h"
+
+#if IS_ENABLED(CONFIG_DRM_PANEL_GOOGLE_MODE_CHECKS)
+/* header and checksum of the long packet carrying each line */
+#define PANEL_LINK_PACKET_OVERHEAD_BYTES	6
+
+/**
+ * panel_link_line_bytes - bytes sent over DSI for one line of a mode
+ * @pmode: mode
+ *
+ * Return: line size including packet overhead.
+ */
+static inline u32 panel_link_line_bytes(const struct exynos_panel_mode *pmode)
+{
+	const struct exynos_display_dsc *dsc = &pmode->exynos_mode.dsc;
+	const struct drm_display_mode *mode = &pmode->mode;
+	u32 bytes;
+
+	if (!dsc->enabled)
+		bytes = DIV_ROUND_UP(mode->hdisplay * pmode->exynos_mode.bpc * 3, 8);
+	else if (dsc->cfg && dsc->cfg->slice_chunk_size)
+		bytes = dsc->cfg->slice_chunk_size * dsc->slice_count;
+	else if (dsc->cfg && dsc->cfg->bits_per_pixel)
+		/* bits_per_pixel is in 1/16 bpp */
+		bytes = DIV_ROUND_UP(mode->hdisplay * dsc->cfg->bits_per_pixel, 16 * 8);
+	else
+		/* partial configurations are completed by the DPU with 8 bpp */
+		bytes = mode->hdisplay;
+
+	return bytes + PANEL_LINK_PACKET_OVERHEAD_BYTES;
+}
+
+/**
+ * panel_mode_name_vrefresh - refresh rate a mode is meant to run at
+ * @mode: mode, named <hdisplay>x<vdisplay>x<vrefresh>
+ *
+ * The rate is taken from the name rather than computed from the clock, so the
+ * clock can be checked against it.
+ *
+ * Return: refresh rate in Hz, 0 if the name doesn't carry one.
+ */
+static inline u32 panel_mode_name_vrefresh(const struct drm_display_mode *mode)
+{
+	const char *p = strrchr(mode->name, 'x');
+	u32 vrefresh;
+
+	if (!p || kstrtou32(p + 1, 10, &vrefresh))
+		return 0;
+
+	return vrefresh;
+}
+
+/* the check of a mode failed, keep checking the others to report all of them */
+#define PANEL_TIMING_ERR(dev, mode, fmt, ...)					\
+({										\
+	dev_err(dev, "%s: " fmt, (mode)->name, ##__VA_ARGS__);			\
+	false;									\
+})
+
+/**
+ * panel_timing_check_mode - check the timings and link budget of a mode
+ * @dev: panel device
+ * @pmode: mode
+ * @hs_clk: DSI lane rate used for @pmode, in Mbps
+ * @lanes: number of DSI data lanes
+ *
+ * Checks that the porches are in order, that the pixel clock gives the refresh
+ * rate in the mode name and that TE and vblank fit in a frame. The command
+ * window is what is left of the frame period after the TE pulse and the idle
+ * time after TE of the underrun parameters, shortened by their TE variation; a
+ * frame has to be sent within it. The utilisation of the link and the headroom
+ * left in the command window are printed with dynamic debug.
+ *
+ * Return: false if any check fails.
+ */
+static inline bool panel_timing_check_mode(struct device *dev,
+					   const struct exynos_panel_mode *pmode, u32 hs_clk,
+					   u32 lanes)
+{
+	const struct exynos_display_underrun_param *up = pmode->exynos_mode.underrun_param;
+	const struct drm_display_mode *mode = &pmode->mode;
+	const u32 te_usec = pmode->exynos_mode.te_usec;
+	const u32 vblank_usec = pmode->exynos_mode.vblank_usec;
+	const u32 vrefresh = panel_mode_name_vrefresh(mode);
+	const u32 line_bytes = panel_link_line_bytes(pmode);
+	u64 period_us, window_us, xfer_us;
+	bool ok = true;
+
+	if (mode->hdisplay >= mode->hsync_start || mode->hsync_start > mode->hsync_end ||
+	    mode->hsync_end >= mode->htotal || mode->vdisplay >= mode->vsync_start ||
+	    mode->vsync_start > mode->vsync_end || mode->vsync_end >= mode->vtotal)
+		ok = PANEL_TIMING_ERR(dev, mode, "porches out of order\n");
+
+	if (!vrefresh)
+		return PANEL_TIMING_ERR(dev, mode, "no refresh rate in the mode name\n");
+
+	if (mode->clock != DIV_ROUND_CLOSEST(mode->htotal * mode->vtotal * vrefresh, 1000))
+		ok = PANEL_TIMING_ERR(dev, mode, "clock %d isn't %dx%d at %u Hz\n", mode->clock,
+				      mode->htotal, mode->vtotal, vrefresh);
+
+	period_us = div_u64(USEC_PER_SEC, vrefresh);
+	if (te_usec + vblank_usec >= period_us)
+		return PANEL_TIMING_ERR(dev, mode, "te %u us and vblank %u us exceed %llu us\n",
+					te_usec, vblank_usec, period_us);
+
+	window_us = period_us - te_usec;
+	if (up) {
+		window_us -= min_t(u64, window_us, up->te_idle_us);
+		window_us = div_u64(window_us * (100 - min_t(u32, up->te_var, 100)), 100);
+	}
+
+	if (!hs_clk || !lanes) {
+		dev_warn(dev, "%s: can't compute link budget\n", mode->name);
+		return ok;
+	}
+
+	/* hs_clk in Mbps is also the number of bits per lane per us */
+	xfer_us = DIV_ROUND_UP_ULL((u64)line_bytes * 8 * mode->vdisplay, hs_clk * lanes);
+	if (xfer_us > window_us)
+		return PANEL_TIMING_ERR(dev, mode,
+					"frame takes %llu us at %u Mbps x%u, window is %llu us\n",
+					xfer_us, hs_clk, lanes, window_us);
+
+	dev_dbg(dev, "%s: link %llu%% busy at %u Mbps x%u, %llu us headroom in %llu us window\n",
+		mode->name, div64_u64(xfer_us * 100, window_us), hs_clk, lanes,
+		window_us - xfer_us, window_us);
+
+	return ok;
+}
+
+/**
+ * panel_timing_check - check the timings and link budget of all modes of a panel
+ * @dev: panel device
+ * @desc: panel description
+ * @hs_clk: slowest DSI lane rate the panel runs at, in Mbps
+ * @lanes: number of DSI data lanes
+ *
+ * Return: 0 if all modes are consistent and fit, -EINVAL otherwise.
+ */
+static inline int panel_timing_check(struct device *dev, const struct exynos_panel_desc *desc,
+				     u32 hs_clk, u32 lanes)
+{
+	const size_t lp_count = desc->lp_mode_count ?: (desc->lp_mode ? 1 : 0);
+	bool ok = true;
+	size_t i;
+
+	for (i = 0; i < desc->num_modes; i++)
+		ok &= panel_timing_check_mode(dev, &desc->modes[i], hs_clk, lanes);
+	for (i = 0; i < lp_count; i++)
+		ok &= panel_timing_check_mode(dev, &desc->lp_mode[i], hs_clk, lanes);
+
+	return ok ? 0 : -EINVAL;
+}
+#else
+static inline int panel_timing_check(struct device *dev, const struct exynos_panel_desc *desc,
+				     u32 hs_clk, u32 lanes)
+{
+	return 0;
+}
+#endif /* CONFIG_DRM_PANEL_GOOGLE_MODE_CHECKS */
+
+#endif /* _PANEL_GOOGLE_TIMING_H_ */